@@ -22,7 +22,10 @@
 #include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <memory>
 #include <random>
+#include <cstdio>
+#include <cstring>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image/stb_image.h>
@@ -30,54 +33,58 @@
 #include "utils/postProcessor.h"
 #include "utils/text_Renderer.h"
 #include "utils/particleMaster.h"
+#include "utils/random.h"
+#include "utils/gameCore.h"
+#include "utils/profiler.h"
+#include "utils/gpuTimer.h"
+#include "utils/sceneRender.h"
+#include "utils/assetLoader.h"
 
-#define VELOCITY 5
-#define MAX_TARGET_SPAWN_DISTANCE 50
 #define MOUSE_SENSITIVITY 0.3f
 #define ZOOM 20.0f
 #define ZOOM_TIME 0.07f
-#define ALPHA_DECAY_TIME 0.2f
-#define GAME_TIME 30.0f
 #define FPS_STEP 0.2f
 
-const glm::vec3 DEFAULT_TARGET_LOCATION = glm::vec3(0.0f, -100.0f, 0.0f);
-const float ALPHA_PER_SECOND = 1.0f / ALPHA_DECAY_TIME;
-
 enum render_passes{ SHADOWMAP, RENDER};
 
 GLuint screenWidth = 1920, screenHeight = 1080;
 
-//game state variables
-int score, totalShots;
-float accuracy;
-
 // callback functions for keyboard and mouse events
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 
 //gameplay functions
-void player_movement();
 void zoom(float amout);
 
-//gameEvent Funtions
-void endGame();
-void updateTargetPosition();
-glm::vec3 getTargetSpawnPoint(glm::vec3 wall1_pos, glm::vec3 wall2_pos, glm::vec3 wall_size, 
-        glm::vec3 lowWall_pos, glm::vec3 lowWall_size);
 
+//one side of the cube map, decoded by stb_image
+struct CubeSide
+{
+    int width, height;
+    unsigned char* image;
+};
 
 //render functions
-GLint LoadTextureCube(string path);
-void renderObjects(Shader& object_shader, Model& cubeModel, Model& sphereModel, GLint render_pass, GLuint depthMap, Model& targetModel);
+GLint LoadTextureCube(string path, AssetLoader& assets);
+void LoadModel(AssetLoader& assets, Model& model, string path);
+void renderScene(Shader& scene_shader, GLint render_pass, GLuint depthMap, const glm::mat4& lightPOV);
+void renderObjects(Shader& object_shader, GLint render_pass, GLuint depthMap, Model** targetModels);
 void renderSkyBox(Shader& shader, Model& cubeModel);
 void renderText(float width, GLfloat currentFrame);
+void renderProfilerStats(float width);
+
+//profiler functions
+void beginZone(int zone);
+void endZone(int zone);
 
 // mouse and keyboard globals
 bool keys[1024];
 GLfloat lastX, lastY;
 double cursorX,cursorY;
 bool firstMouse = true;
+//events and mouse movement received since the last game tick
+PlayerInput pendingInput;
 
 // parameters for time calculation
 GLfloat deltaTime = 0.0f;
@@ -125,81 +132,25 @@ Material wallMaterial = {
 };
 
 // helper classes init
-Physics physicsEngine;
-btRigidBody* target;
-Camera camera(glm::vec3(0.0f, 1.7f, 9.0f), GL_TRUE, physicsEngine);
+GameCore* game;
 PostProcessor* postEffects;
 TextRenderer* Text;
 ParticleMaster* particles;
+Profiler* profiler;
+GpuTimer* gpuTimer;
+SceneRenderer* sceneRenderer;
 
 //global variables for game loop
-bool hasBeenShot = false;
 bool zoomIn = false;
-bool playing = false;
 bool vSync = true;
+bool showProfiler = false;
 float FOV;
-GLfloat gameTimer;
 
 //FPS calc variables
 int nbFrames;
 int FPS;
-float timePerFrame;
 double lastTime;
 
-//object variables
-glm::vec3 wall1_pos = glm::vec3(20.0f, 3.0f, -20.0f);
-glm::vec3 wall1_size = glm::vec3(1.0f, 6.0f, 70.0f);
-glm::vec3 wall1_rot = glm::vec3(0.0f, 0.0f, 0.0f);
-
-glm::vec3 wall2_pos = glm::vec3(-20.0f, 3.0f, -20.0f);
-glm::vec3 wall2_size = glm::vec3(1.0f, 6.0f, 70.0f);
-glm::vec3 wall2_rot = glm::vec3(0.0f, 0.0f, 0.0f);
-
-glm::vec3 backWall_pos = glm::vec3(0.0f, 3.0f, 30.0f);
-glm::vec3 backWall_size = glm::vec3(40.0f, 6.0f, 1.0f);
-glm::vec3 backWall_rot = glm::vec3(0.0f, 0.0f, 0.0f);
-
-glm::vec3 frontWall_pos = glm::vec3(0.0f, 3.0f, -80.0f);
-glm::vec3 frontWall_size = glm::vec3(40.0f, 6.0f, 1.0f);
-glm::vec3 frontWall_rot = glm::vec3(0.0f, 0.0f, 0.0f);
-
-glm::vec3 lowWall_pos = glm::vec3(0.0f, 0.5f, -5.0f);
-glm::vec3 lowWall_size = glm::vec3(30.0f, 1.0f, 0.3f);
-glm::vec3 lowWall_rot = glm::vec3(0.0f, 0.0f, 0.0f);
-
-glm::vec3 target_pos = glm::vec3(0.0f, -100.0f, 0.0f);
-glm::vec3 target_size = glm::vec3(0.5f, 0.5f, 0.5f);
-
-glm::vec3 plane_pos = glm::vec3(0.0f, 0.0f, -20.0f);
-glm::vec3 plane_size = glm::vec3(40.0f, 0.1f, 70.0f);
-glm::vec3 plane_rot = glm::vec3(0.0f, 0.0f, 0.0f);
-
-
-// Model and Normal transformation matrices for the objects in the scene
-glm::mat4 targetModelMatrix = glm::mat4(1.0f);
-glm::mat3 targetNormalMatrix = glm::mat3(1.0f);
-
-glm::mat4 planeModelMatrix = glm::mat4(1.0f);
-glm::mat3 planeNormalMatrix = glm::mat3(1.0f);
-
-glm::mat4 wall1ModelMatrix = glm::mat4(1.0f);
-glm::mat3 wall1NormalMatrix = glm::mat3(1.0f);
-
-glm::mat4 wall2ModelMatrix = glm::mat4(1.0f);
-glm::mat3 wall2NormalMatrix = glm::mat3(1.0f);
-
-glm::mat4 lowWallModelMatrix = glm::mat4(1.0f);
-glm::mat3 lowWallNormalMatrix = glm::mat3(1.0f);
-
-glm::mat4 backWallModelMatrix = glm::mat4(1.0f);
-glm::mat3 backWallNormalMatrix = glm::mat3(1.0f);
-
-glm::mat4 frontWallModelMatrix = glm::mat4(1.0f);
-glm::mat3 frontWallNormalMatrix = glm::mat3(1.0f);
-
-//current index of the target model
-int currentTargetModelIndex;
-
 GLFWwindow* windowInit()
 {
     //glfw and window setup
@@ -235,9 +186,56 @@ GLFWwindow* windowInit()
     return window;
 }
 
-int main()
+int main(int argc, char** argv)
 {
 
+    //the seed drives targets and particles, passing the same one with --seed replays the same session
+    uint64_t seed = ((uint64_t)std::random_device()() << 32) | std::random_device()();
+    //rate of the fixed simulation step, independent from the frame rate
+    float tickRate = DEFAULT_TICK_RATE;
+    //threads of the physics world, more than one selects the multithreaded world
+    int physicsThreads = 1;
+    //targets alive at the same time, more than one makes a gridshot drill
+    int targetCount = DEFAULT_TARGET_COUNT;
+    //Chrome trace of the frame zones, not recorded without --trace
+    const char* tracePath = NULL;
+    //paths of the targets, see MOTION_PROFILES
+    const MotionProfile* motion = &MOTION_PROFILES[0];
+    //static geometry of the map, see maps/default.map
+    const char* mapPath = DEFAULT_MAP_PATH;
+    //upload the materials with a uniform buffer instead of one uniform per field
+    bool materialUBO = false;
+    for (int i = 1; i < argc; i++)
+        if (strcmp(argv[i], "--material-ubo") == 0)
+            materialUBO = true;
+    for (int i = 1; i < argc - 1; i++)
+    {
+        if (strcmp(argv[i], "--seed") == 0)
+            seed = strtoull(argv[i + 1], nullptr, 10);
+        else if (strcmp(argv[i], "--tick-rate") == 0 && atof(argv[i + 1]) > 0.0)
+            tickRate = (float)atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--physics-threads") == 0)
+            physicsThreads = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--targets") == 0 && atoi(argv[i + 1]) > 0)
+            targetCount = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--trace") == 0)
+            tracePath = argv[i + 1];
+        else if (strcmp(argv[i], "--map") == 0)
+            mapPath = argv[i + 1];
+        else if (strcmp(argv[i], "--motion") == 0 && findMotionProfile(argv[i + 1]))
+            motion = findMotionProfile(argv[i + 1]);
+    }
+    GameRandom().setSeed(seed);
+    std::cout << "Random seed: " << seed << std::endl;
+
+    //before opening the window, the game can't run without its map
+    Scene scene;
+    if (!scene.load(mapPath))
+    {
+        std::cout << "Can't load the map " << mapPath << ", run the game from the repository root or pass --map" << std::endl;
+        return -1;
+    }
+
     GLFWwindow* window = windowInit();
 
     //define the viewport dimensions
@@ -253,15 +251,43 @@ int main()
 
     glClearColor(0.26f, 0.46f, 0.98f, 1.0f);
 
+    //worker threads for the asset decoding at startup, then for the particle simulation
+    JobSystem jobSystem;
+    //the assets are decoded on the workers while this thread goes on with the init, they are uploaded by assets.finish()
+    AssetLoader assets(jobSystem);
+    double loadStart = glfwGetTime();
+
+    //load the models
+    Model cubeModel, sphereModel, randomShape1Model, pyramidModel;
+    LoadModel(assets, cubeModel, "models/cube.obj");
+    LoadModel(assets, sphereModel, "models/sphere.obj");
+    LoadModel(assets, randomShape1Model, "models/randomShape1.obj");
+    LoadModel(assets, pyramidModel, "models/pyramid.obj");
+
+    textureCube = LoadTextureCube("textures/cube/Maskonaive2/", assets);
+
+    //text renderer instance, the glyphs are rasterized on a worker
+    Text = new TextRenderer(width, height);
+    std::shared_ptr<FontBitmaps> font = std::make_shared<FontBitmaps>();
+    assets.add([font]() { TextRenderer::Rasterize("Fonts/arial.ttf", 24, *font); }, [font]() { Text->Upload(*font); });
+
     //shaders init
     Shader ui_shader = Shader("shaders/UI.vert", "shaders/UI.frag");
     Shader effectsShader = Shader("shaders/postProcess.vert", "shaders/postProcess.frag");
     Shader shadow_shader("shaders/shadowMap.vert", "shaders/shadowMap.frag");
-    Shader illumination_shader = Shader("shaders/shadows.vert", "shaders/shadows.frag");
+    Shader illumination_shader = Shader("shaders/shadows.vert", "shaders/shadows.frag", materialUBO ? "#define MATERIAL_UBO\n" : NULL);
+    //the static objects of the map are drawn instanced, with the model matrices in the instance attributes
+    Shader scene_shadow_shader("shaders/shadowMap.vert", "shaders/shadowMap.frag", "#define INSTANCED\n");
+    Shader scene_shader("shaders/shadows.vert", "shaders/shadows.frag", materialUBO ? "#define MATERIAL_UBO\n#define INSTANCED\n" : "#define INSTANCED\n");
+    MaterialBuffer materialBuffer;
+    if (materialUBO)
+    {
+        illumination_shader.setMaterialBuffer(&materialBuffer);
+        scene_shader.setMaterialBuffer(&materialBuffer);
+    }
     Shader particleShader = Shader("shaders/paticle.vert", "shaders/paticle.frag");
     
     Shader skyboxShader("shaders/SkyBox.vert", "shaders/SkyBox.frag");
-    textureCube = LoadTextureCube("textures/cube/Maskonaive2/");
 
     //buffer for shadows init
     const GLuint SHADOW_WIDTH = 4096, SHADOW_HEIGHT = 4096;
@@ -290,37 +316,43 @@ int main()
     // Projection matrix of the camera: FOV angle, aspect ratio, near and far planes
     projection = glm::perspective(45.0f, (float)screenWidth/(float)screenHeight, 0.1f, 10000.0f);
 
-    //post and text renderers instances
-    postEffects = &PostProcessor(effectsShader, width, height);
-    Text = new TextRenderer(width, height);
-    Text->Load("Fonts/arial.ttf", 24);
+    //post processing renderer instance
+    postEffects = new PostProcessor(effectsShader, width, height);
 
-    particles = &ParticleMaster(particleShader);
+    particles = new ParticleMaster(particleShader, MAX_PARTICLES, &jobSystem);
 
-    //load the models
-    Model cubeModel("models/cube.obj");
-    Model sphereModel("models/sphere.obj");
-    Model randomShape1Model("models/randomShape1.obj");
-    Model pyramidModel("models/pyramid.obj");
-
-    //array to pick at random from for the target model
-    Model* modelRefArray[4] = {&cubeModel, &sphereModel, &randomShape1Model, &pyramidModel};
-    currentTargetModelIndex = rand() % 4;
-
-    //rigidBody for all solid objects
-    btRigidBody* plane = physicsEngine.createRigidBody(BOX,plane_pos,plane_size,plane_rot,0.0f,0.3f,0.0f);
-    btRigidBody* wall1 = physicsEngine.createRigidBody(BOX,wall1_pos,wall1_size,wall1_rot,0.0f,0.3f,0.0f);
-    btRigidBody* wall2 = physicsEngine.createRigidBody(BOX,wall2_pos,wall2_size,wall2_rot,0.0f,0.3f,0.0f);
-    btRigidBody* lowWall = physicsEngine.createRigidBody(BOX,lowWall_pos,lowWall_size,lowWall_rot,0.0f,0.3f,0.0f);
-    btRigidBody* backWall = physicsEngine.createRigidBody(BOX,backWall_pos,backWall_size,backWall_rot,0.0f,0.3f,0.0f);
-    btRigidBody* frontWall = physicsEngine.createRigidBody(BOX,frontWall_pos,frontWall_size,frontWall_rot,0.0f,0.3f,0.0f);
-    if(currentTargetModelIndex == 1)
-        target = physicsEngine.createRigidBody(SPHERE,target_pos,target_size,glm::vec3(0.0f, 0.0f, 0.0f),0.0f,0.3f,0.0f);
-    else
-        target = physicsEngine.createRigidBody(BOX,target_pos,target_size,glm::vec3(0.0f, 0.0f, 0.0f),0.0f,0.3f,0.0f);
+    //game state and physics, the renderer only reads it
+    game = new GameCore(GameRandom(), scene, tickRate, DEFAULT_MAX_SUBSTEPS, physicsThreads, targetCount);
+    game->targets.motion.profile = *motion;
+    game->onTargetHit = [](glm::vec3 position) { particles->generateParticles(position); };
+
+    //target models, indexed by the model index of each target
+    Model* modelRefArray[TARGET_MODEL_COUNT] = {&cubeModel, &sphereModel, &randomShape1Model, &pyramidModel};
+    const char* modelNames[TARGET_MODEL_COUNT] = {"cube", "sphere", "randomShape1", "pyramid"};
+
+    //models used by the map, the ones not loaded above are read from models/<name>.obj
+    std::vector<Model> mapModels;
+    mapModels.reserve(game->scene.modelNames.size());
+    std::vector<Model*> sceneModels;
+    for (const string& name : game->scene.modelNames)
+    {
+        Model* model = NULL;
+        for (int i = 0; i < TARGET_MODEL_COUNT; i++)
+            if (name == modelNames[i])
+                model = modelRefArray[i];
+        if (!model)
+        {
+            mapModels.emplace_back();
+            model = &mapModels.back();
+            LoadModel(assets, *model, "models/" + name + ".obj");
+        }
+        sceneModels.push_back(model);
+    }
 
-    //maximum delta time for the physical simulation
-    GLfloat maxSecPerFrame = 1.0f / 60.0f;
+    assets.finish();
+    std::cout << "Assets loaded in " << (int)((glfwGetTime() - loadStart) * 1000.0) << " ms" << std::endl;
+
+    sceneRenderer = new SceneRenderer(game->scene, sceneModels.data());
 
     // Projection matrix: FOV angle, aspect ratio, near and far planes
     FOV = 45.0f;
@@ -343,26 +375,36 @@ int main()
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid*)0);
 
-    //game variables init
-    score = 0;
-    totalShots = 0;
-    gameTimer = GAME_TIME;
+    //FPS variables init
     nbFrames = 0;
     FPS = 0;
-    timePerFrame = 1.0;
     lastTime = glfwGetTime();
 
     glfwSwapInterval(vSync);
 
+    //CPU and GPU timings of the zones of the frame
+    profiler = new Profiler();
+    gpuTimer = new GpuTimer();
+    TraceWriter trace;
+    if (tracePath && trace.open(tracePath))
+    {
+        profiler->setTrace(&trace);
+        std::cout << "Recording a trace to " << tracePath << std::endl;
+    }
+
     // Rendering loop: this code is executed at each frame
     while(!glfwWindowShouldClose(window))
     {
+        profiler->beginFrame();
+        gpuTimer->beginZone(ZONE_FRAME);
 
         //elapsed time calc
         GLfloat currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        profiler->beginZone(ZONE_INPUT);
+
         // Check is an I/O event is happening
         glfwPollEvents();
         
@@ -376,40 +418,29 @@ int main()
             }
         }
 
-        //apply FPS camera movements
-        player_movement();
-        camera.updateCameraPos();
-        // View matrix (=camera): position, view direction, camera "up" vector
-        view = camera.GetViewMatrix();
+        //advance the game by the time of this frame, the simulation runs at a fixed tick rate
+        PlayerInput input = pendingInput;
+        input.forward = keys[GLFW_KEY_W];
+        input.backward = keys[GLFW_KEY_S];
+        input.left = keys[GLFW_KEY_A];
+        input.right = keys[GLFW_KEY_D];
+        pendingInput = PlayerInput();
+        profiler->endZone(ZONE_INPUT);
 
-        //"match" state handling
-        if(playing) 
         {
-            gameTimer -= deltaTime;
-
-            if (gameTimer > 0.0f)
-            {
-                //target fade away and respwan
-                if (hasBeenShot) 
-                {
-                    if(targetMaterial.alpha > 0.0f)
-                    {
-                        targetMaterial.alpha -= ALPHA_PER_SECOND * deltaTime;
-                    }
-                    else
-                    {
-                        updateTargetPosition();
-                        hasBeenShot = false;
-                    }
-                }
-            }
-            else
-                endGame();
-            
+            ProfileZone zone(profiler, ZONE_PHYSICS);
+            game->update(deltaTime, input);
         }
 
-        //advance physics simulation by a step
-        physicsEngine.dynamicsWorld->stepSimulation((deltaTime < maxSecPerFrame ? deltaTime : maxSecPerFrame),10);
+        // View matrix (=camera): position, view direction, camera "up" vector
+        view = game->camera.GetViewMatrix();
+
+        //the particle simulation runs on the worker threads during the shadow and main passes
+        profiler->beginZone(ZONE_PARTICLES);
+        particles->Update(deltaTime, view);
+        profiler->endZone(ZONE_PARTICLES);
+
+        beginZone(ZONE_SHADOWS);
 
         //Shadow map creation
         glm::mat4 lightProjection, lightView;
@@ -422,15 +453,20 @@ int main()
         lightView = glm::lookAt(dirLight, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));       
         lightPOV = lightProjection * lightView;
         
-        shadow_shader.Use();
-        glUniformMatrix4fv(glGetUniformLocation(shadow_shader.Program, "lightPOV"), 1, GL_FALSE, glm::value_ptr(lightPOV));
         glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
         glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
         glClear(GL_DEPTH_BUFFER_BIT);
 
-        renderObjects(shadow_shader,cubeModel,sphereModel, SHADOWMAP, depthMap, *modelRefArray[currentTargetModelIndex]);
+        renderScene(scene_shadow_shader, SHADOWMAP, depthMap, lightPOV);
+
+        shadow_shader.Use();
+        glUniformMatrix4fv(shadow_shader.uniforms[UNIFORM_LIGHT_POV], 1, GL_FALSE, glm::value_ptr(lightPOV));
+        renderObjects(shadow_shader, SHADOWMAP, depthMap, modelRefArray);
 
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        endZone(ZONE_SHADOWS);
+
+        beginZone(ZONE_MAIN);
 
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -444,31 +480,40 @@ int main()
         renderSkyBox(skyboxShader, cubeModel);
 
         //use shadow map with illumination shaders to render the scene
+        renderScene(scene_shader, RENDER, depthMap, lightPOV);
+
         illumination_shader.Use();
 
-        glUniformMatrix4fv(glGetUniformLocation(illumination_shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(illumination_shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(illumination_shader.Program, "lightPOV"), 1, GL_FALSE, glm::value_ptr(lightPOV));
-        GLint lightDirLocation = glGetUniformLocation(illumination_shader.Program, "lightVector");
+        glUniformMatrix4fv(illumination_shader.uniforms[UNIFORM_PROJECTION], 1, GL_FALSE, glm::value_ptr(projection));
+        glUniformMatrix4fv(illumination_shader.uniforms[UNIFORM_VIEW], 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(illumination_shader.uniforms[UNIFORM_LIGHT_POV], 1, GL_FALSE, glm::value_ptr(lightPOV));
+        GLint lightDirLocation = illumination_shader.uniforms[UNIFORM_LIGHT_VECTOR];
         glUniform3fv(lightDirLocation, 1, glm::value_ptr(dirLight));
         
     
-        renderObjects(illumination_shader, cubeModel, sphereModel, RENDER, depthMap, *modelRefArray[currentTargetModelIndex]);
+        renderObjects(illumination_shader, RENDER, depthMap, modelRefArray);
+        endZone(ZONE_MAIN);
 
         //render alive particles
+        beginZone(ZONE_PARTICLES);
         particleShader.Use();
 
-        glUniform3f(glGetUniformLocation(particleShader.Program, "cameraRightVector"), view[0][0], view[1][0], view[2][0]);
-		glUniform3f(glGetUniformLocation(particleShader.Program, "cameraUpVector")   , view[0][1], view[1][1], view[2][1]);
+        glUniform3f(particleShader.uniforms[UNIFORM_CAMERA_RIGHT], view[0][0], view[1][0], view[2][0]);
+		glUniform3f(particleShader.uniforms[UNIFORM_CAMERA_UP]   , view[0][1], view[1][1], view[2][1]);
         glm::mat4 ViewProjectionMatrix = projection * view;
-		glUniformMatrix4fv(glGetUniformLocation(particleShader.Program, "ViewProjection"), 1, GL_FALSE, &ViewProjectionMatrix[0][0]);
+		glUniformMatrix4fv(particleShader.uniforms[UNIFORM_VIEW_PROJECTION], 1, GL_FALSE, &ViewProjectionMatrix[0][0]);
 
-        particles->Render(deltaTime, view);
+        particles->Render();
+        endZone(ZONE_PARTICLES);
 
+        beginZone(ZONE_POST);
         //stop rendering to texture
         postEffects->EndRender();
         //apply post processing and render
         postEffects->Render(zoomIn);
+        endZone(ZONE_POST);
+
+        beginZone(ZONE_TEXT);
 
         //render UI and text on top of post processed texture
         ui_shader.Use();
@@ -478,116 +523,36 @@ int main()
         glBindVertexArray(0);
 
         renderText(width, currentFrame);
-        
-        glfwSwapBuffers(window);
-    }
-}
-
-//reset game variables and pick a stating target position
-void startNewGame()
-{
-    score = 0;
-    totalShots = 0;
-    gameTimer = GAME_TIME;
-    playing = true;
-    updateTargetPosition();
-}
-
-//move target rigidbody outside the scene and reset material variables
-void endGame()
-{
-    playing = false;
-    btTransform newPos;
-    newPos.setIdentity();
-    newPos.setOrigin(btVector3(DEFAULT_TARGET_LOCATION.x, DEFAULT_TARGET_LOCATION.y, DEFAULT_TARGET_LOCATION.z));
-    target->getMotionState()->setWorldTransform(newPos);
-    target->setWorldTransform(newPos);
-    targetMaterial.Color.diffuse = TARGET_DEFAULT_COLOR;
-    targetMaterial.Color.specular = TARGET_DEFAULT_COLOR;
-    targetMaterial.Color.ambient = TARGET_DEFAULT_COLOR;
-    targetMaterial.alpha = 1.0f;
-    hasBeenShot = false;
-}
-
-//move target model and rigidbody to a new position and pick a new random model to render
-void updateTargetPosition()
-{
-    target_pos = getTargetSpawnPoint(wall1_pos, wall2_pos, wall1_size, lowWall_pos, lowWall_size);
-    btTransform newPos;
-    newPos.setIdentity();
-    newPos.setOrigin(btVector3(target_pos.x, target_pos.y, target_pos.z));
-    currentTargetModelIndex = rand() % 4;
-
-    if(currentTargetModelIndex == 1)
-        target = physicsEngine.createRigidBody(SPHERE,target_pos,target_size,glm::vec3(0.0f, 0.0f, 0.0f),0.0f,0.3f,0.0f);
-    else
-        target = physicsEngine.createRigidBody(BOX,target_pos,target_size,glm::vec3(0.0f, 0.0f, 0.0f),0.0f,0.3f,0.0f);
-
-    target->getMotionState()->setWorldTransform(newPos);
-    target->setWorldTransform(newPos);
-    targetMaterial.Color.diffuse = TARGET_DEFAULT_COLOR;
-    targetMaterial.Color.specular = TARGET_DEFAULT_COLOR;
-    targetMaterial.Color.ambient = TARGET_DEFAULT_COLOR;
-    targetMaterial.alpha = 1.0f;
-}
-
-//called by the player pressing left-click, implements shooting mechanics
-void hitScanShoot()
-{
-    totalShots++;
-
-    //use raycasting to find if the target was hit
-    btVector3 btFrom(camera.Position.x, camera.Position.y, camera.Position.z);
-    glm::vec3 rayEnd = camera.Position + (camera.Front * 200.0f);
-    btVector3 btTo(rayEnd.x, rayEnd.y, rayEnd.z);
+        endZone(ZONE_TEXT);
 
-    btCollisionWorld::ClosestRayResultCallback res(btFrom, btTo);
+        gpuTimer->endZone(ZONE_FRAME);
+        gpuTimer->endFrame(*profiler);
 
-    physicsEngine.dynamicsWorld->rayTest(btFrom, btTo, res);
+        profiler->beginZone(ZONE_SWAP);
+        glfwSwapBuffers(window);
+        profiler->endZone(ZONE_SWAP);
 
-    if(res.hasHit())
-    {
-        //target hit response
-        if(res.m_collisionObject->getWorldTransform() == target->getWorldTransform())
-        {
-            hasBeenShot = true;
-            targetMaterial.Color.diffuse = TARGET_HIT_COLOR;
-            targetMaterial.Color.specular = TARGET_HIT_COLOR;
-            targetMaterial.Color.ambient = TARGET_HIT_COLOR;
-            particles->generateParticles(target_pos);
-            btTransform newPos;
-            newPos.setIdentity();
-            //move the hitbox out of the way until the fade away is done
-            newPos.setOrigin(btVector3(DEFAULT_TARGET_LOCATION.x, DEFAULT_TARGET_LOCATION.y, DEFAULT_TARGET_LOCATION.z));
-            target->getMotionState()->setWorldTransform(newPos);
-            target->setWorldTransform(newPos);
-            score++;
-        }
+        profiler->endFrame();
     }
 
+    profiler->setTrace(NULL);
+    trace.close();
+    delete sceneRenderer;
+    delete gpuTimer;
+    delete profiler;
 }
 
-//pick a point in the 3D space delimited by the specified geometry
-glm::vec3 getTargetSpawnPoint(glm::vec3 wall1_pos, glm::vec3 wall2_pos, glm::vec3 wall_size, 
-        glm::vec3 lowWall_pos, glm::vec3 lowWall_size)
+//a profiler zone timed both on the CPU and on the GPU
+void beginZone(int zone)
 {
-    float spawnRangeX = wall1_pos.x - wall2_pos.x - (wall_size.x * 2) - 1;
-    float spawnRangeY = 2.0f;
-
-    float spawnWorldOffsetX = wall2_pos.x + wall_size.x + 0.5;
-    float spawnWorldOffsetZ = lowWall_pos.z - (lowWall_size.z / 2) - 10;
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> distX(0, spawnRangeX);
-    std::uniform_real_distribution<> distY(0, spawnRangeY);
-    std::uniform_real_distribution<> distZ(0, MAX_TARGET_SPAWN_DISTANCE);
-
-    float x = distX(gen) + spawnWorldOffsetX;
-    float y = distY(gen) + 1.0f;
-    float z = -distZ(gen) + spawnWorldOffsetZ;
+    profiler->beginZone(zone);
+    gpuTimer->beginZone(zone);
+}
 
-    return glm::vec3(x, y, z);
+void endZone(int zone)
+{
+    gpuTimer->endZone(zone);
+    profiler->endZone(zone);
 }
 
 //zoom by changing the FOV
@@ -600,37 +565,26 @@ void zoom(float amout)
     projection = glm::perspective(glm::radians(FOV), (float)screenWidth/(float)screenHeight, 0.1f, 10000.0f);
 }
 
-//Move by setting the camera's rigigidBody linear velocity, y is taken from existing velocity to allow jumping with addForce
-void player_movement()
-{
-    btVector3 direction = btVector3(0, camera.playerBody->getLinearVelocity().getY(), 0);
-    if(camera.isJumping)
-    {
-        if (camera.Position.y <= 1.8) camera.isJumping = false;
-    }
-    if(keys[GLFW_KEY_W])
-        direction += btVector3(camera.WorldFront.x * VELOCITY, camera.WorldFront.y, camera.WorldFront.z * VELOCITY);
-    if(keys[GLFW_KEY_S])
-        direction += btVector3(-camera.WorldFront.x * VELOCITY, camera.WorldFront.y, -camera.WorldFront.z * VELOCITY);
-    if(keys[GLFW_KEY_A])
-        direction += btVector3(-camera.Right.x * VELOCITY, camera.WorldFront.y, -camera.Right.z * VELOCITY);
-    if(keys[GLFW_KEY_D])
-        direction += btVector3(camera.Right.x * VELOCITY, camera.WorldFront.y, camera.Right.z * VELOCITY);
-
-    camera.playerBody->setLinearVelocity(direction);
-}
-
 void toggleVsync()
 {
     vSync = !vSync;
     glfwSwapInterval(vSync);
 }
 
+//switch between sorted alpha blending and order independent additive blending for the particles
+void toggleParticleBlending()
+{
+    if (particles->getBlending() == PARTICLE_BLEND_ALPHA)
+        particles->setBlending(PARTICLE_BLEND_ADDITIVE);
+    else
+        particles->setBlending(PARTICLE_BLEND_ALPHA);
+}
+
 //mouse keybinds
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
-        if(playing) hitScanShoot();
+        pendingInput.shoot = true;
 
     if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS)
     {
@@ -652,17 +606,17 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 
     if(key == GLFW_KEY_SPACE && action == GLFW_PRESS)
     {
-        camera.jump();
+        pendingInput.jump = true;
     }
 
     if(key == GLFW_KEY_E && action == GLFW_PRESS)
     {
-        startNewGame();
+        game->startNewGame();
     }
     
     if(key == GLFW_KEY_BACKSPACE && action == GLFW_PRESS)
     {
-        endGame();
+        game->endGame();
     }
 
     if(key == GLFW_KEY_TAB && action == GLFW_PRESS)
@@ -670,6 +624,16 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         toggleVsync();
     }
 
+    if(key == GLFW_KEY_B && action == GLFW_PRESS)
+    {
+        toggleParticleBlending();
+    }
+
+    if(key == GLFW_KEY_P && action == GLFW_PRESS)
+    {
+        showProfiler = !showProfiler;
+    }
+
     if(action == GLFW_PRESS)
         keys[key] = true;
     else if(action == GLFW_RELEASE)
@@ -699,29 +663,39 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
     lastX = xpos;
     lastY = ypos;
 
-    //pass the offset to the Camera class instance in order to update the rendering
-    camera.ProcessMouseMovement(xoffset * MOUSE_SENSITIVITY, yoffset * MOUSE_SENSITIVITY);
+    //accumulate the offset, the camera is rotated by the next game tick
+    pendingInput.lookX += xoffset * MOUSE_SENSITIVITY;
+    pendingInput.lookY += yoffset * MOUSE_SENSITIVITY;
 
 }
 
 //load one side of the cube texture
-void LoadTextureCubeSide(string path, string side_image, GLuint side_name)
+//a side of the cube texture, decoded on a worker and uploaded when ready
+void LoadTextureCubeSide(AssetLoader& assets, GLuint texture, string path, string side_image, GLuint side_name)
 {
-    int w, h;
-    unsigned char* image;
-    string fullname;
-
-    fullname = path + side_image;
-
-    image = stbi_load(fullname.c_str(), &w, &h, 0, STBI_rgb);
-    if (image == nullptr)
-        std::cout << "Failed to load texture!" << std::endl;
-    glTexImage2D(side_name, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+    std::shared_ptr<CubeSide> side = std::make_shared<CubeSide>();
+    string fullname = path + side_image;
 
-    stbi_image_free(image);
+    assets.add([side, fullname]() {
+        side->image = stbi_load(fullname.c_str(), &side->width, &side->height, 0, STBI_rgb);
+    }, [side, texture, side_name]() {
+        if (side->image == nullptr)
+        {
+            std::cout << "Failed to load texture!" << std::endl;
+            return;
+        }
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        //stb_image rows are tightly packed
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(side_name, 0, GL_RGB, side->width, side->height, 0, GL_RGB, GL_UNSIGNED_BYTE, side->image);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+        stbi_image_free(side->image);
+        side->image = nullptr;
+    });
 }
 
-GLint LoadTextureCube(string path)
+GLint LoadTextureCube(string path, AssetLoader& assets)
 {
     GLuint textureImage;
 
@@ -730,14 +704,6 @@ GLint LoadTextureCube(string path)
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_CUBE_MAP, textureImage);
 
-    //load each side of the cube texture
-    LoadTextureCubeSide(path, std::string("posx.jpg"), GL_TEXTURE_CUBE_MAP_POSITIVE_X);
-    LoadTextureCubeSide(path, std::string("negx.jpg"), GL_TEXTURE_CUBE_MAP_NEGATIVE_X);
-    LoadTextureCubeSide(path, std::string("posy.jpg"), GL_TEXTURE_CUBE_MAP_POSITIVE_Y);
-    LoadTextureCubeSide(path, std::string("negy.jpg"), GL_TEXTURE_CUBE_MAP_NEGATIVE_Y);
-    LoadTextureCubeSide(path, std::string("posz.jpg"), GL_TEXTURE_CUBE_MAP_POSITIVE_Z);
-    LoadTextureCubeSide(path, std::string("negz.jpg"), GL_TEXTURE_CUBE_MAP_NEGATIVE_Z);
-
     //set texture parameters
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -747,10 +713,26 @@ GLint LoadTextureCube(string path)
 
     glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
+    //load each side of the cube texture, the sides are decoded in parallel
+    LoadTextureCubeSide(assets, textureImage, path, std::string("posx.jpg"), GL_TEXTURE_CUBE_MAP_POSITIVE_X);
+    LoadTextureCubeSide(assets, textureImage, path, std::string("negx.jpg"), GL_TEXTURE_CUBE_MAP_NEGATIVE_X);
+    LoadTextureCubeSide(assets, textureImage, path, std::string("posy.jpg"), GL_TEXTURE_CUBE_MAP_POSITIVE_Y);
+    LoadTextureCubeSide(assets, textureImage, path, std::string("negy.jpg"), GL_TEXTURE_CUBE_MAP_NEGATIVE_Y);
+    LoadTextureCubeSide(assets, textureImage, path, std::string("posz.jpg"), GL_TEXTURE_CUBE_MAP_POSITIVE_Z);
+    LoadTextureCubeSide(assets, textureImage, path, std::string("negz.jpg"), GL_TEXTURE_CUBE_MAP_NEGATIVE_Z);
+
     return textureImage;
 
 }
 
+//the model is read (cooked meshes or Assimp import) on a worker, its meshes are created on the GL thread
+void LoadModel(AssetLoader& assets, Model& model, string path)
+{
+    std::shared_ptr<ModelData> data = std::make_shared<ModelData>();
+    Model* target = &model;
+    assets.add([data, path]() { Model::read(path, *data); }, [data, target]() { target->upload(*data); });
+}
+
 //skybox rendering with a cube map
 void renderSkyBox(Shader& skyboxShader, Model& cubeModel)
 {
@@ -762,11 +744,11 @@ void renderSkyBox(Shader& skyboxShader, Model& cubeModel)
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_CUBE_MAP, textureCube);
-    glUniformMatrix4fv(glGetUniformLocation(skyboxShader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniformMatrix4fv(skyboxShader.uniforms[UNIFORM_PROJECTION], 1, GL_FALSE, glm::value_ptr(projection));
     //rotation only part of view matrix to avoid moving the skybox with the camera translation
     glm::mat4 rotationOnlyView = glm::mat4(glm::mat3(view));
-    glUniformMatrix4fv(glGetUniformLocation(skyboxShader.Program, "view"), 1, GL_FALSE, glm::value_ptr(rotationOnlyView));
-    GLint textureLocation = glGetUniformLocation(skyboxShader.Program, "skybox");
+    glUniformMatrix4fv(skyboxShader.uniforms[UNIFORM_VIEW], 1, GL_FALSE, glm::value_ptr(rotationOnlyView));
+    GLint textureLocation = skyboxShader.uniforms[UNIFORM_SKYBOX];
     glUniform1i(textureLocation, 0);
 
     cubeModel.Draw();
@@ -779,18 +761,18 @@ void renderSkyBox(Shader& skyboxShader, Model& cubeModel)
 //screen text renderer function, also calculates FPS
 void renderText(float width, GLfloat currentFrame)
 {
-    Text->RenderText("Hits: " + to_string(score), 20.0f, 20.0f, 1.0f);
-    Text->RenderText("Shots: " + to_string(totalShots), 20.0f, 50.0f, 1.0f);
+    Text->RenderText("Hits: " + to_string(game->score), 20.0f, 20.0f, 1.0f);
+    Text->RenderText("Shots: " + to_string(game->totalShots), 20.0f, 50.0f, 1.0f);
     
-    if (totalShots > 0)
+    if (game->totalShots > 0)
     {
-        string accString = to_string(((float)score/(float)totalShots) * 100);
+        string accString = to_string(((float)game->score/(float)game->totalShots) * 100);
         Text->RenderText("Accuracy: " + accString.substr(0, accString.find(".")+3) + "%", 20.0f, 80.0f, 1.0f);
     }
 
-    if(playing)
+    if(game->playing)
     {
-        string timeString = to_string(gameTimer);
+        string timeString = to_string(game->gameTimer);
         Text->RenderText(timeString.substr(0, timeString.find(".")+2), (width/2.0f) - 30.0f, 100.0f, 1.0f);
         Text->RenderText("Press BACKSPACE to stop", 20.0f, 110.0f, 1.0f);
     }
@@ -803,116 +785,102 @@ void renderText(float width, GLfloat currentFrame)
     nbFrames++;
     if ( currentFrame - lastTime >= FPS_STEP)
     {
-        timePerFrame = (FPS_STEP * 1000.0f)/float(nbFrames);
         FPS = nbFrames * (1.0f/FPS_STEP);
         nbFrames = 0;
         lastTime += FPS_STEP;
     }
     Text->RenderText("FPS: " + to_string(FPS), (width) - 300.0f, 50.0f, 1.0f);
-    Text->RenderText("Time per frame: " + to_string(timePerFrame), (width) - 300.0f, 80.0f, 1.0f);
+
+    //the frame time percentiles take the row of the old average time per frame
+    renderProfilerStats(width);
 
     Text->RenderText("press TAB to switch vSync mode", (width) - 400.0f, 20.0f, 1.0f);
 }
 
-//main objects render function, called once for shadow mapping and once for rendering to screen
-void renderObjects(Shader& shader, Model& cubeModel, Model& sphereModel, GLint render_pass, GLuint depthMap, Model& targetModel)
+//static objects of the map, one instanced draw per model. Called once for shadow mapping and once for rendering to screen
+void renderScene(Shader& shader, GLint render_pass, GLuint depthMap, const glm::mat4& lightPOV)
 {
-    
+    shader.Use();
+    glUniformMatrix4fv(shader.uniforms[UNIFORM_LIGHT_POV], 1, GL_FALSE, glm::value_ptr(lightPOV));
+
     if (render_pass == RENDER)
     {
+        glUniformMatrix4fv(shader.uniforms[UNIFORM_PROJECTION], 1, GL_FALSE, glm::value_ptr(projection));
+        glUniformMatrix4fv(shader.uniforms[UNIFORM_VIEW], 1, GL_FALSE, glm::value_ptr(view));
+        glUniform3fv(shader.uniforms[UNIFORM_LIGHT_VECTOR], 1, glm::value_ptr(dirLight));
+
         glActiveTexture(GL_TEXTURE2);
         glBindTexture(GL_TEXTURE_2D, depthMap);
-        GLint shadowLocation = glGetUniformLocation(shader.Program, "shadowMap");
-        glUniform1i(shadowLocation, 2);
+        glUniform1i(shader.uniforms[UNIFORM_SHADOW_MAP], 2);
         shader.updateMaterial(wallMaterial);
     }
 
-    planeModelMatrix = glm::mat4(1.0f);
-    planeNormalMatrix = glm::mat3(1.0f);
-    planeModelMatrix = glm::translate(planeModelMatrix, plane_pos);
-    planeModelMatrix = glm::scale(planeModelMatrix, plane_size);
-    planeNormalMatrix = glm::inverseTranspose(glm::mat3(view*planeModelMatrix));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "modelMatrix"), 1, GL_FALSE, glm::value_ptr(planeModelMatrix));
-    glUniformMatrix3fv(glGetUniformLocation(shader.Program, "normalMatrix"), 1, GL_FALSE, glm::value_ptr(planeNormalMatrix));
-
-    cubeModel.Draw();
+    sceneRenderer->draw();
+}
 
-    wall1ModelMatrix = glm::mat4(1.0f);
-    wall1NormalMatrix = glm::mat3(1.0f);
-    wall1ModelMatrix = glm::translate(wall1ModelMatrix, wall1_pos);
-    wall1ModelMatrix = glm::scale(wall1ModelMatrix, wall1_size);
-    wall1NormalMatrix = glm::inverseTranspose(glm::mat3(view*wall1ModelMatrix));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "modelMatrix"), 1, GL_FALSE, glm::value_ptr(wall1ModelMatrix));
-    glUniformMatrix3fv(glGetUniformLocation(shader.Program, "normalMatrix"), 1, GL_FALSE, glm::value_ptr(wall1NormalMatrix));
+//targets render function, called once for shadow mapping and once for rendering to screen
+void renderObjects(Shader& shader, GLint render_pass, GLuint depthMap, Model** targetModels)
+{
     
-    cubeModel.Draw();
-
-    wall2ModelMatrix = glm::mat4(1.0f);
-    wall2NormalMatrix = glm::mat3(1.0f);
-    wall2ModelMatrix = glm::translate(wall2ModelMatrix, wall2_pos);
-    wall2ModelMatrix = glm::scale(wall2ModelMatrix, wall2_size);
-    wall2NormalMatrix = glm::inverseTranspose(glm::mat3(view*wall2ModelMatrix));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "modelMatrix"), 1, GL_FALSE, glm::value_ptr(wall2ModelMatrix));
-    glUniformMatrix3fv(glGetUniformLocation(shader.Program, "normalMatrix"), 1, GL_FALSE, glm::value_ptr(wall2NormalMatrix));
-
-    cubeModel.Draw();
-
-    lowWallModelMatrix = glm::mat4(1.0f);
-    lowWallNormalMatrix = glm::mat3(1.0f);
-    lowWallModelMatrix = glm::translate(lowWallModelMatrix, lowWall_pos);
-    lowWallModelMatrix = glm::scale(lowWallModelMatrix, lowWall_size);
-    lowWallNormalMatrix = glm::inverseTranspose(glm::mat3(view*lowWallModelMatrix));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "modelMatrix"), 1, GL_FALSE, glm::value_ptr(lowWallModelMatrix));
-    glUniformMatrix3fv(glGetUniformLocation(shader.Program, "normalMatrix"), 1, GL_FALSE, glm::value_ptr(lowWallNormalMatrix));
-
-    cubeModel.Draw();
+    if (render_pass == RENDER)
+    {
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, depthMap);
+        GLint shadowLocation = shader.uniforms[UNIFORM_SHADOW_MAP];
+        glUniform1i(shadowLocation, 2);
+    }
 
-    backWallModelMatrix = glm::mat4(1.0f);
-    backWallNormalMatrix = glm::mat3(1.0f);
-    backWallModelMatrix = glm::translate(backWallModelMatrix, backWall_pos);
-    backWallModelMatrix = glm::scale(backWallModelMatrix, backWall_size);
-    backWallNormalMatrix = glm::inverseTranspose(glm::mat3(view*backWallModelMatrix));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "modelMatrix"), 1, GL_FALSE, glm::value_ptr(backWallModelMatrix));
-    glUniformMatrix3fv(glGetUniformLocation(shader.Program, "normalMatrix"), 1, GL_FALSE, glm::value_ptr(backWallNormalMatrix));
+    if(!game->playing)
+        return;
 
-    cubeModel.Draw();
+    //all the targets of the drill, hit ones fade away in the hit color
+    TargetManager& targets = game->targets;
+    for (int i = 0; i < targets.count(); i++)
+    {
+        if (targets.state[i] == TARGET_INACTIVE)
+            continue;
 
-    frontWallModelMatrix = glm::mat4(1.0f);
-    frontWallNormalMatrix = glm::mat3(1.0f);
-    frontWallModelMatrix = glm::translate(frontWallModelMatrix, frontWall_pos);
-    frontWallModelMatrix = glm::scale(frontWallModelMatrix, frontWall_size);
-    frontWallNormalMatrix = glm::inverseTranspose(glm::mat3(view*frontWallModelMatrix));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "modelMatrix"), 1, GL_FALSE, glm::value_ptr(frontWallModelMatrix));
-    glUniformMatrix3fv(glGetUniformLocation(shader.Program, "normalMatrix"), 1, GL_FALSE, glm::value_ptr(frontWallNormalMatrix));
+        glm::mat4 targetModelMatrix = glm::translate(glm::mat4(1.0f), targets.renderPosition[i]);
+        targetModelMatrix = glm::scale(targetModelMatrix, targets.size);
+        glm::mat3 targetNormalMatrix = glm::inverseTranspose(glm::mat3(view*targetModelMatrix));
+        glUniformMatrix4fv(shader.uniforms[UNIFORM_MODEL_MATRIX], 1, GL_FALSE, glm::value_ptr(targetModelMatrix));
+        glUniformMatrix3fv(shader.uniforms[UNIFORM_NORMAL_MATRIX], 1, GL_FALSE, glm::value_ptr(targetNormalMatrix));
 
-    cubeModel.Draw();
+        if(render_pass == RENDER)
+        {
+            glm::vec3 targetColor = (targets.state[i] == TARGET_FADING) ? TARGET_HIT_COLOR : TARGET_DEFAULT_COLOR;
+            targetMaterial.Color.diffuse = targetColor;
+            targetMaterial.Color.specular = targetColor;
+            targetMaterial.Color.ambient = targetColor;
+            targetMaterial.alpha = targets.alpha[i];
+            shader.updateMaterial(targetMaterial);
+        }
 
-    planeModelMatrix = glm::mat4(1.0f);
-    wall1ModelMatrix = glm::mat4(1.0f);
-    wall2ModelMatrix = glm::mat4(1.0f);
-    lowWallModelMatrix = glm::mat4(1.0f);
-    backWallModelMatrix = glm::mat4(1.0f);
-    frontWallModelMatrix = glm::mat4(1.0f);
+        targetModels[targets.modelIndex[i]]->Draw();
+    }
+}
 
+//frame time percentiles of the last PROFILER_FRAMES frames, with the time of every zone when the profiler view is on
+void renderProfilerStats(float width)
+{
+    char line[128];
+    ZoneStats frame = profiler->getStats(ZONE_FRAME, false);
+    snprintf(line, sizeof(line), "Frame ms p50 %.2f p99 %.2f max %.2f", frame.p50, frame.p99, frame.max);
+    Text->RenderText(line, (width) - 400.0f, 80.0f, 1.0f);
 
-    if(playing) 
+    if (!showProfiler)
     {
-        targetModelMatrix = glm::mat4(1.0f);
-        targetNormalMatrix = glm::mat3(1.0f);
-        targetModelMatrix = glm::translate(targetModelMatrix, target_pos);
-        targetModelMatrix = glm::scale(targetModelMatrix, target_size);
-        targetNormalMatrix = glm::inverseTranspose(glm::mat3(view*targetModelMatrix));
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "modelMatrix"), 1, GL_FALSE, glm::value_ptr(targetModelMatrix));
-        glUniformMatrix3fv(glGetUniformLocation(shader.Program, "normalMatrix"), 1, GL_FALSE, glm::value_ptr(targetNormalMatrix));
-
-        if(render_pass == RENDER) shader.updateMaterial(targetMaterial);
-
-        targetModel.Draw();
-
-        targetModelMatrix = glm::mat4(1.0f);
+        Text->RenderText("press P for the profiler", (width) - 400.0f, 110.0f, 1.0f);
+        return;
     }
 
-    targetModelMatrix = glm::mat4(1.0f);
-
+    Text->RenderText("zone: CPU p50/p99/max, GPU p50/p99/max (ms)", (width) - 600.0f, 110.0f, 0.8f);
+    for (int zone = 0; zone < ZONE_COUNT; zone++)
+    {
+        ZoneStats cpu = profiler->getStats(zone, false);
+        ZoneStats gpu = profiler->getStats(zone, true);
+        snprintf(line, sizeof(line), "%s: %.2f/%.2f/%.2f, %.2f/%.2f/%.2f", ZONE_NAMES[zone], cpu.p50, cpu.p99, cpu.max,
+            gpu.p50, gpu.p99, gpu.max);
+        Text->RenderText(line, (width) - 600.0f, 135.0f + zone * 25.0f, 0.8f);
+    }
 }
-
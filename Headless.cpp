@@ -0,0 +1,230 @@
+/*
+Headless runner
+- plays whole sessions of the game core without a window or GL context, at an uncapped tick rate
+- the player is a script that strafes, turns towards the closest target with some reaction time and aim error, and shoots
+
+Used to soak-test and benchmark the simulation on machines without a GPU, e.g.
+    Headless --sessions 1000 --tick-rate 120 --seed 42 --targets 1 --motion static --map maps/default.map
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "utils/gameCore.h"
+#include "utils/jobSystem.h"
+#include "utils/random.h"
+
+//scripted player parameters
+#define SCRIPT_TURN_SPEED 540.0f
+#define SCRIPT_REACTION_TIME 0.18f
+#define SCRIPT_AIM_ERROR 0.6f
+#define SCRIPT_FIRE_INTERVAL 0.12f
+#define SCRIPT_STRAFE_TIME 0.6f
+
+//result of a single session
+struct SessionResult
+{
+    int score;
+    int totalShots;
+    int ticks;
+};
+
+//scripted input generator, it only reads the game state like a human player looking at the screen would
+class ScriptedPlayer
+{
+public:
+    ScriptedPlayer(uint64_t seed)
+        : random(seed), reactionTimer(SCRIPT_REACTION_TIME), fireTimer(0.0f), strafeTimer(0.0f), strafeLeft(false),
+        aimError(0.0f), lastTarget(-1), lastSpawn(DEFAULT_TARGET_LOCATION)
+    {
+    }
+
+    PlayerInput nextInput(GameCore& game, float deltaTime)
+    {
+        PlayerInput input = {};
+
+        //strafe left and right, changing direction at random intervals
+        this->strafeTimer -= deltaTime;
+        if (this->strafeTimer <= 0.0f)
+        {
+            this->strafeLeft = !this->strafeLeft;
+            this->strafeTimer = this->random.range(0.5f, 1.5f) * SCRIPT_STRAFE_TIME;
+        }
+        input.left = this->strafeLeft;
+        input.right = !this->strafeLeft;
+
+        //aim at the alive target closest to the crosshair
+        int target = -1;
+        float bestAngle = 0.0f;
+        for (int i = 0; i < game.targets.count(); i++)
+        {
+            if (game.targets.state[i] != TARGET_ALIVE)
+                continue;
+            float angle = glm::dot(glm::normalize(game.targets.position[i] - game.camera.Position), game.camera.Front);
+            if (target < 0 || angle > bestAngle)
+            {
+                target = i;
+                bestAngle = angle;
+            }
+        }
+        if (target < 0)
+            return input;
+        glm::vec3 targetPos = game.targets.position[target];
+
+        //a new target needs some time to be noticed, the moving ones are told apart by their spawn point
+        glm::vec3 targetSpawn = game.targets.motion.anchor[target];
+        if (target != this->lastTarget || targetSpawn != this->lastSpawn)
+        {
+            this->lastTarget = target;
+            this->lastSpawn = targetSpawn;
+            this->reactionTimer = SCRIPT_REACTION_TIME * this->random.range(0.7f, 1.3f);
+            this->aimError = this->random.range(-SCRIPT_AIM_ERROR, SCRIPT_AIM_ERROR);
+        }
+        this->reactionTimer -= deltaTime;
+        this->fireTimer -= deltaTime;
+        if (this->reactionTimer > 0.0f)
+            return input;
+
+        //turn towards the target (with a small error on the yaw), limited by the turn speed
+        glm::vec3 toTarget = targetPos - game.camera.Position;
+        float targetYaw = glm::degrees(std::atan2(toTarget.z, toTarget.x)) + this->aimError;
+        float targetPitch = glm::degrees(std::asin(toTarget.y / glm::length(toTarget)));
+
+        float yawDelta = std::remainder(targetYaw - game.camera.Yaw, 360.0f);
+        float pitchDelta = targetPitch - game.camera.Pitch;
+        float maxTurn = SCRIPT_TURN_SPEED * deltaTime;
+        yawDelta = glm::clamp(yawDelta, -maxTurn, maxTurn);
+        pitchDelta = glm::clamp(pitchDelta, -maxTurn, maxTurn);
+
+        //the camera scales the offsets by its mouse sensitivity
+        input.lookX = yawDelta / game.camera.MouseSensitivity;
+        input.lookY = pitchDelta / game.camera.MouseSensitivity;
+
+        //shoot once the crosshair is close to the target
+        float targetAngle = glm::degrees(std::atan2(game.targets.size.x, glm::length(toTarget)));
+        if (std::fabs(yawDelta) < targetAngle * 2.0f && std::fabs(pitchDelta) < targetAngle * 2.0f && this->fireTimer <= 0.0f)
+        {
+            input.shoot = true;
+            this->fireTimer = SCRIPT_FIRE_INTERVAL;
+            //the next shot at this target is more precise
+            this->aimError *= 0.5f;
+        }
+
+        return input;
+    }
+
+private:
+    Random random;
+    float reactionTimer;
+    float fireTimer;
+    float strafeTimer;
+    bool strafeLeft;
+    float aimError;
+    int lastTarget;
+    glm::vec3 lastSpawn;
+};
+
+//play a whole timed session with a fixed tick
+SessionResult runSession(uint64_t seed, float tickRate, int targetCount, const MotionProfile& motion, const Scene& scene)
+{
+    //same expression as the fixed step of the core, so each update runs exactly one tick
+    float tickTime = 1.0f / tickRate;
+    Random gameRandom(seed);
+    GameCore game(gameRandom, scene, tickRate, DEFAULT_MAX_SUBSTEPS, 1, targetCount);
+    game.targets.motion.profile = motion;
+    ScriptedPlayer player(seed ^ 0x5DEECE66Dull);
+
+    SessionResult result = {};
+    game.startNewGame();
+    while (game.playing)
+    {
+        PlayerInput input = player.nextInput(game, tickTime);
+        game.update(tickTime, input);
+        result.ticks++;
+    }
+    result.score = game.score;
+    result.totalShots = game.totalShots;
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int sessions = 100;
+    float tickRate = 120.0f;
+    uint64_t seed = 1;
+    int workers = 0;
+    int targetCount = DEFAULT_TARGET_COUNT;
+    const MotionProfile* motion = &MOTION_PROFILES[0];
+    const char* mapPath = DEFAULT_MAP_PATH;
+
+    for (int i = 1; i < argc - 1; i++)
+    {
+        if (strcmp(argv[i], "--sessions") == 0)
+            sessions = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--tick-rate") == 0)
+            tickRate = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0)
+            seed = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--workers") == 0)
+            workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--targets") == 0)
+            targetCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--motion") == 0)
+            motion = findMotionProfile(argv[++i]);
+        else if (strcmp(argv[i], "--map") == 0)
+            mapPath = argv[++i];
+    }
+    if (sessions <= 0 || tickRate <= 0.0f || targetCount <= 0 || !motion)
+    {
+        std::cout << "Usage: Headless [--sessions N] [--tick-rate HZ] [--seed S] [--workers N] [--targets N] [--motion ";
+        for (int i = 0; i < MOTION_PROFILE_COUNT; i++)
+            std::cout << (i > 0 ? "|" : "") << MOTION_PROFILES[i].name;
+        std::cout << "] [--map PATH]" << std::endl;
+        return 1;
+    }
+
+    //loaded (and cooked if needed) once, the sessions only read it
+    Scene scene;
+    if (!scene.load(mapPath))
+    {
+        std::cout << "Can't load the map " << mapPath << ", run from the repository root or pass --map" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Running " << sessions << " sessions at " << tickRate << " Hz with " << targetCount << " " << motion->name << " targets, seed " << seed << std::endl;
+
+    //sessions are independent, each one owns its physics world and generators, so they run in parallel.
+    //Session i always uses seed + i, the results don't depend on the number of workers
+    std::vector<SessionResult> results(sessions);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        JobSystem jobs(workers);
+        jobs.ParallelFor(sessions, 1, [&](int begin, int end) {
+            for (int i = begin; i < end; i++)
+                results[i] = runSession(seed + i, tickRate, targetCount, *motion, scene);
+        });
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long long ticks = 0;
+    long long score = 0, shots = 0;
+    for (const SessionResult& result : results)
+    {
+        ticks += result.ticks;
+        score += result.score;
+        shots += result.totalShots;
+    }
+
+    std::cout << "Time: " << seconds << " s, " << (sessions / seconds) * 60.0 << " sessions/min, "
+        << ticks / seconds << " ticks/s" << std::endl;
+    std::cout << "Average hits: " << (double)score / sessions << ", shots: " << (double)shots / sessions;
+    if (shots > 0)
+        std::cout << ", accuracy: " << 100.0 * score / shots << "%";
+    std::cout << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,31 @@
+//minimal timing helper shared by the micro-benchmarks
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+//volatile sink to keep the compiler from removing the benchmarked work
+inline volatile float benchSink;
+
+//runs fn iterations times for each sample and prints the best and median time per iteration
+inline void runBenchmark(const char* name, int samples, int iterations, const std::function<void()>& fn)
+{
+    //warm up caches and branch predictors
+    fn();
+
+    std::vector<double> times(samples);
+    for (int s = 0; s < samples; s++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+            fn();
+        times[s] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+    }
+
+    std::sort(times.begin(), times.end());
+    std::cout << name << ": best " << times[0] << " us, median " << times[samples / 2] << " us" << std::endl;
+}
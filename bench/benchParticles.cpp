@@ -0,0 +1,51 @@
+//micro-benchmarks of the particle simulation kernels, on the CPU only
+
+#include <vector>
+
+#include "bench.h"
+#include "utils/jobSystem.h"
+#include "utils/particle.h"
+#include "utils/random.h"
+
+#define BENCH_DELTA_TIME (1.0f / 144.0f)
+
+//fill the store with particles that never die, spread around the origin
+void fillStore(ParticleStore& store, Random& random)
+{
+    store.count = 0;
+    for (int i = 0; i < store.capacity; i++)
+        store.spawn(random.inSphere() * 10.0f, random.inSphere() * 10.5f + glm::vec3(0.0f, 3.0f, 0.0f), 0.3f, 1.0e9f, random.range(0.1f, 0.6f));
+}
+
+int main()
+{
+    Random random(1);
+    ParticleStore store(MAX_PARTICLES), compacted(MAX_PARTICLES);
+    fillStore(store, random);
+
+    std::vector<int> deadIndices(MAX_PARTICLES);
+    glm::vec3 cameraPos = glm::vec3(0.0f, 1.7f, 9.0f);
+
+    std::cout << "particles: " << store.count << ", SIMD width: " << PARTICLE_SIMD_WIDTH << std::endl;
+
+    runBenchmark("integrate", 50, 100, [&]() {
+        benchSink = (float)integrateParticles(store, 0, store.count, BENCH_DELTA_TIME, cameraPos, deadIndices.data());
+    });
+
+    JobSystem jobs;
+    runBenchmark("integrate (job system)", 50, 100, [&]() {
+        jobs.ParallelFor(store.count, 1024, [&](int begin, int end) {
+            integrateParticles(store, begin, end, BENCH_DELTA_TIME, cameraPos, &deadIndices[begin]);
+        });
+    });
+
+    //every other particle dies
+    std::vector<int> remap(MAX_PARTICLES);
+    for (int i = 0; i < store.count; i++)
+        remap[i] = (i % 2 == 0) ? i / 2 : -1;
+    runBenchmark("compact half", 50, 100, [&]() {
+        store.compactInto(compacted, remap.data(), 0, store.count);
+    });
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+//micro-benchmarks of the game core: simulation tick and hit scan
+
+#include "bench.h"
+#include "utils/gameCore.h"
+#include "utils/random.h"
+
+int main()
+{
+    Scene scene;
+    if (!scene.load(DEFAULT_MAP_PATH))
+    {
+        std::cout << "Can't load the map " << DEFAULT_MAP_PATH << ", run the benchmark from the repository root" << std::endl;
+        return 1;
+    }
+
+    Random random(1);
+    GameCore game(random, scene);
+    game.startNewGame();
+
+    PlayerInput idle = {};
+    PlayerInput moving = {};
+    moving.forward = true;
+    moving.left = true;
+    moving.lookX = 1.0f;
+
+    runBenchmark("tick idle", 20, 1000, [&]() { game.tick(idle); });
+    runBenchmark("tick moving", 20, 1000, [&]() { game.update(game.getFixedStep(), moving); });
+
+    //the shots are rewound to the last tick, reviving the target keeps every shot on the full path.
+    //The tick benchmarks ran past the end of the game, a new one records alive targets in the history
+    game.startNewGame();
+    game.update(game.getFixedStep(), idle);
+    runBenchmark("hit scan", 20, 1000, [&]() {
+        game.targets.state[0] = TARGET_ALIVE;
+        benchSink = (float)game.hitScanShoot();
+    });
+
+    //gridshot drill, the shot tests all the targets
+    Random gridRandom(1);
+    GameCore grid(gridRandom, scene, DEFAULT_TICK_RATE, DEFAULT_MAX_SUBSTEPS, 1, 50);
+    grid.startNewGame();
+    grid.update(grid.getFixedStep(), idle);
+    runBenchmark("hit scan, 50 targets", 20, 1000, [&]() { benchSink = (float)grid.hitScanShoot(); });
+    runBenchmark("tick, 50 targets", 20, 1000, [&]() { grid.tick(idle); });
+
+    //tracking drill, all the targets move on mixed paths
+    Random trackRandom(1);
+    GameCore track(trackRandom, scene, DEFAULT_TICK_RATE, DEFAULT_MAX_SUBSTEPS, 1, 50);
+    track.targets.motion.profile = *findMotionProfile("mixed");
+    track.startNewGame();
+    runBenchmark("tick, 50 moving targets", 20, 100, [&]() { track.tick(idle); });
+
+    //spread weapon: PELLETS rays in a cone from the player towards the back of the map
+    const int PELLETS = 8;
+    btVector3 from[PELLETS], to[PELLETS];
+    RayHit hits[PELLETS];
+    Random spread(2);
+    for (int i = 0; i < PELLETS; i++)
+    {
+        glm::vec3 end = PLAYER_START_POSITION + glm::normalize(glm::vec3(0.0f, 0.0f, -1.0f) + spread.inSphere() * 0.05f) * 200.0f;
+        from[i] = btVector3(PLAYER_START_POSITION.x, PLAYER_START_POSITION.y, PLAYER_START_POSITION.z);
+        to[i] = btVector3(end.x, end.y, end.z);
+    }
+
+    runBenchmark("spread, one rayTest per pellet", 20, 1000, [&]() {
+        for (int i = 0; i < PELLETS; i++)
+        {
+            btCollisionWorld::ClosestRayResultCallback res(from[i], to[i]);
+            res.m_collisionFilterGroup = COL_RAY;
+            res.m_collisionFilterMask = COL_HITSCAN_MASK;
+            game.physicsEngine.dynamicsWorld->rayTest(from[i], to[i], res);
+            benchSink = res.m_closestHitFraction;
+        }
+    });
+    runBenchmark("spread, batched", 20, 1000, [&]() {
+        game.physicsEngine.rayTestBatch(from, to, PELLETS, hits);
+        benchSink = hits[0].fraction;
+    });
+
+    //a fan of rays over the gridshot drill: the rays cross most of the map, every one is tested among 50 targets
+    const int FAN = 64;
+    btVector3 fanFrom[FAN], fanTo[FAN];
+    RayHit fanHits[FAN];
+    for (int i = 0; i < FAN; i++)
+    {
+        float angle = glm::radians(-45.0f + 90.0f * i / (FAN - 1));
+        glm::vec3 end = PLAYER_START_POSITION + glm::vec3(glm::sin(angle), 0.02f * (i % 8), -glm::cos(angle)) * 200.0f;
+        fanFrom[i] = btVector3(PLAYER_START_POSITION.x, PLAYER_START_POSITION.y, PLAYER_START_POSITION.z);
+        fanTo[i] = btVector3(end.x, end.y, end.z);
+    }
+
+    runBenchmark("fan of 64 rays, 50 targets, one rayTest per ray", 20, 100, [&]() {
+        for (int i = 0; i < FAN; i++)
+        {
+            btCollisionWorld::ClosestRayResultCallback res(fanFrom[i], fanTo[i]);
+            res.m_collisionFilterGroup = COL_RAY;
+            res.m_collisionFilterMask = COL_HITSCAN_MASK;
+            grid.physicsEngine.dynamicsWorld->rayTest(fanFrom[i], fanTo[i], res);
+            benchSink = res.m_closestHitFraction;
+        }
+    });
+    runBenchmark("fan of 64 rays, 50 targets, batched", 20, 100, [&]() {
+        grid.physicsEngine.rayTestBatch(fanFrom, fanTo, FAN, fanHits);
+        benchSink = fanHits[0].fraction;
+    });
+
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include "assetLoader.h"
+
+AssetLoader::AssetLoader(JobSystem& jobs)
+    : jobs(jobs), uploaded(0)
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+    this->jobs.Wait(this->counter);
+}
+
+void AssetLoader::add(std::function<void()> decode, std::function<void()> upload)
+{
+    int index = (int)this->uploads.size();
+    this->uploads.push_back(std::move(upload));
+
+    this->jobs.Run([this, index, decode = std::move(decode)]() {
+        decode();
+        {
+            std::lock_guard<std::mutex> lock(this->decodedMutex);
+            this->decoded.push_back(index);
+        }
+        this->decodedCondition.notify_one();
+    }, this->counter);
+}
+
+void AssetLoader::finish()
+{
+    while (this->uploaded < (int)this->uploads.size())
+    {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(this->decodedMutex);
+            this->decodedCondition.wait(lock, [this]() { return !this->decoded.empty(); });
+            index = this->decoded.front();
+            this->decoded.pop_front();
+        }
+
+        //moved out so the data captured by the upload is released as soon as it is done
+        std::function<void()> upload = std::move(this->uploads[index]);
+        upload();
+        this->uploaded++;
+    }
+}
@@ -0,0 +1,50 @@
+/*
+AssetLoader class
+- loads the assets in two stages: the decode (file reading, image decoding, mesh import, glyph rasterization) runs on the
+  workers of a JobSystem, the upload of the result runs on the GL thread
+- the uploads run in the order the decodes finish, so the GL thread uploads the first finished assets while the workers
+  are still decoding the others, and it is free for other startup work until finish is called
+
+The decode and upload of an asset usually share its CPU data through a shared_ptr captured by both.
+*/
+
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "jobSystem.h"
+
+class AssetLoader
+{
+public:
+    AssetLoader(JobSystem& jobs);
+    //waits for the decodes still running, their uploads are dropped
+    ~AssetLoader();
+    AssetLoader(const AssetLoader& copy) = delete;
+    AssetLoader& operator=(const AssetLoader& copy) = delete;
+
+    //decode runs on a worker right away, upload runs in finish once decode returned. Must be called on the GL thread
+    void add(std::function<void()> decode, std::function<void()> upload);
+    //run the uploads as the decodes finish, returns when all the assets added so far are uploaded
+    void finish();
+
+private:
+    JobSystem& jobs;
+    JobCounter counter;
+
+    //uploads of the added assets, each one runs once
+    std::vector<std::function<void()>> uploads;
+    int uploaded;
+
+    //indexes of the assets decoded and not yet uploaded
+    std::deque<int> decoded;
+    std::mutex decodedMutex;
+    std::condition_variable decodedCondition;
+};
+
+#endif
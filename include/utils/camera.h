@@ -81,9 +81,10 @@ public:
         //create a rigidbody to associate with the campera position
         glm::vec3 player_size = glm::vec3(0.5f, 1.8f, 0.5f);
         glm::vec3 bodyPosition = glm::vec3(position.x, position.y - (player_size.y / 2) + 0.1f, position.z);
-        this->playerBody =  physicsEngine.createRigidBody(CYLINDER, bodyPosition, player_size, glm::vec3(0.0f), 65.0f, 0.3f, 0.1f);
+        this->playerBody =  physicsEngine.createRigidBody(CYLINDER, bodyPosition, player_size, glm::vec3(0.0f), 65.0f, 0.3f, 0.1f, COL_PLAYER, COL_PLAYER_MASK);
 
         playerHeightFromCenter = (player_size.y / 2) - 0.1f;
+        isJumping = false;
         //can only rotate around y
         this->playerBody->setAngularFactor(btVector3(0.0f, 1.0f, 0.0f));
         this->playerBody->setActivationState(DISABLE_DEACTIVATION);
@@ -105,11 +106,17 @@ public:
         }
     }
 
+    //camera position for the current rigidbody position
+    glm::vec3 getBodyCameraPos()
+    {
+        btVector3 bodyPos = this->playerBody->getCenterOfMassPosition();
+        return glm::vec3(bodyPos.getX(), bodyPos.getY() - 0.1, bodyPos.getZ());
+    }
+
     //sync camera with rigidbody position
     void updateCameraPos()
     {
-        btVector3 bodyPos = this->playerBody->getCenterOfMassPosition();
-        this->Position = glm::vec3(bodyPos.getX(), bodyPos.getY() - 0.1, bodyPos.getZ());
+        this->Position = this->getBodyCameraPos();
     }
 
     //////////////////////////////////////////
@@ -0,0 +1,67 @@
+/*
+Cooked map format
+- binary form of a text map, written by Scene the first time the map is loaded (maps/name.map -> maps/name.mapc)
+- flat arrays of 16 byte aligned records, read in place from a MappedFile: no text parsing or matrix math at load
+- the header carries the format version, the hash of the text source it was cooked from (a changed source is cooked
+  again) and a checksum of everything after the header (a truncated or corrupted file is cooked again)
+
+Layout: CookedMapHeader, then objectCount CookedShape, objectCount CookedInstance and modelCount CookedModel at the
+offsets of the header. The objects are sorted by model. The files are little endian, like every platform the game runs on.
+*/
+
+#ifndef COOKED_MAP_H
+#define COOKED_MAP_H
+
+#include <cstdint>
+
+//"AMAP"
+#define COOKED_MAP_MAGIC 0x50414D41u
+//increase at every change of the records below
+#define COOKED_MAP_VERSION 1
+#define COOKED_MAP_EXTENSION "c"
+#define COOKED_MODEL_NAME_SIZE 56
+
+struct CookedMapHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceHash;
+    uint64_t checksum;
+    uint32_t objectCount;
+    uint32_t modelCount;
+    float spawnMin[4];
+    float spawnMax[4];
+    uint32_t shapeOffset;
+    uint32_t instanceOffset;
+    uint32_t modelOffset;
+    uint32_t fileSize;
+};
+
+//physics collider: box of half extents size, Euler rotation as in btQuaternion::setEuler
+struct CookedShape
+{
+    float position[4];
+    float size[4];
+    float rotation[4];
+};
+
+//render instance: model matrix and world space normal matrix, column major, the mat3 columns padded to 4 floats
+struct CookedInstance
+{
+    float modelMatrix[16];
+    float normalMatrix[12];
+};
+
+//objects [first, first + count) are drawn with models/<name>.obj
+struct CookedModel
+{
+    char name[COOKED_MODEL_NAME_SIZE];
+    uint32_t first;
+    uint32_t count;
+};
+
+static_assert(sizeof(CookedMapHeader) % 16 == 0, "the cooked map records must stay 16 byte aligned");
+static_assert(sizeof(CookedShape) == 48 && sizeof(CookedInstance) == 112 && sizeof(CookedModel) == 64,
+    "changing the cooked map records needs a new COOKED_MAP_VERSION");
+
+#endif
@@ -0,0 +1,48 @@
+/*
+Cooked mesh format
+- final vertex and index buffers of a model, written by Model after the Assimp import (models/name.obj -> models/name.objc)
+- the next launches map the file and upload the buffers straight from the mapping, Assimp is not run at all
+- the header is keyed by the hash of the source file and the Assimp import flags, a change of either cooks the model
+  again, and carries a checksum of everything after it (a truncated or corrupted file is cooked again)
+
+Layout: CookedMeshHeader, meshCount CookedMeshRange at rangeOffset, then the vertices (Vertex of mesh.h) and the
+GLuint indices of all the meshes at the offsets of their ranges, every array 16 byte aligned. Little endian.
+*/
+
+#ifndef COOKED_MESH_H
+#define COOKED_MESH_H
+
+#include <cstdint>
+
+//"AMSH"
+#define COOKED_MESH_MAGIC 0x48534D41u
+//increase at every change of the records below or of the Vertex layout
+#define COOKED_MESH_VERSION 1
+#define COOKED_MESH_EXTENSION "c"
+
+struct CookedMeshHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceHash;
+    uint32_t importFlags;
+    uint32_t meshCount;
+    uint64_t checksum;
+    uint32_t rangeOffset;
+    uint32_t fileSize;
+    uint32_t padding[2];
+};
+
+//offsets in bytes from the start of the file
+struct CookedMeshRange
+{
+    uint32_t vertexOffset;
+    uint32_t vertexCount;
+    uint32_t indexOffset;
+    uint32_t indexCount;
+};
+
+static_assert(sizeof(CookedMeshHeader) == 48 && sizeof(CookedMeshRange) == 16,
+    "changing the cooked mesh records needs a new COOKED_MESH_VERSION");
+
+#endif
@@ -0,0 +1,156 @@
+#include "gameCore.h"
+
+GameCore::GameCore(Random& random, const Scene& scene, float tickRate, int maxSubSteps, int physicsThreads, int targetCount)
+    : physicsEngine(physicsThreads > 1, physicsThreads), camera(PLAYER_START_POSITION, GL_TRUE, physicsEngine),
+    targets(physicsEngine, spawnVolume, random), scene(scene), score(0), totalShots(0), playing(false), gameTimer(GAME_TIME), random(random),
+    fixedStep(1.0f / tickRate), maxSubSteps(maxSubSteps), accumulator(0.0), tickCount(0), presentedTick(-1), presentedAlpha(0.0f)
+{
+    this->createMap();
+    this->buildSpawnVolume();
+
+    this->camera.updateCameraPos();
+    this->previousCameraPos = this->currentCameraPos = this->camera.Position;
+
+    this->targets.create(targetCount, TARGET_SIZE);
+}
+
+GameCore::~GameCore()
+{
+    this->physicsEngine.Clear();
+}
+
+//create a static rigidBody for each object of the map
+void GameCore::createMap()
+{
+    for (int i = 0; i < this->scene.count(); i++)
+        this->physicsEngine.createRigidBody(BOX, this->scene.position[i], this->scene.size[i], this->scene.rotation[i], 0.0f, 0.3f, 0.0f);
+}
+
+void GameCore::update(float frameTime, const PlayerInput& input)
+{
+    //events of this frame, they act on the view the player is currently seeing
+    if (input.lookX != 0.0f || input.lookY != 0.0f)
+        this->camera.ProcessMouseMovement(input.lookX, input.lookY);
+    if (input.jump)
+        this->camera.jump();
+    if (input.shoot && this->playing)
+        this->hitScanShoot();
+
+    this->accumulator += frameTime;
+    double maxAccumulated = (double)this->maxSubSteps * this->fixedStep;
+    if (this->accumulator > maxAccumulated)
+        this->accumulator = maxAccumulated;
+
+    while (this->accumulator >= this->fixedStep)
+    {
+        this->tick(input);
+        this->accumulator -= this->fixedStep;
+    }
+
+    //render the state between the last two steps
+    float alpha = (float)(this->accumulator / this->fixedStep);
+    this->camera.Position = glm::mix(this->previousCameraPos, this->currentCameraPos, alpha);
+    this->targets.interpolate(alpha);
+    this->presentedTick = this->tickCount - 1;
+    this->presentedAlpha = alpha;
+}
+
+void GameCore::tick(const PlayerInput& input)
+{
+    this->previousCameraPos = this->currentCameraPos;
+    this->targets.beginTick();
+
+    //apply FPS camera movements
+    this->player_movement(input);
+
+    //"match" state handling
+    if(this->playing)
+    {
+        this->gameTimer -= this->fixedStep;
+
+        //targets fade away and respawn
+        if (this->gameTimer > 0.0f)
+            this->targets.update(this->fixedStep);
+        else
+            this->endGame();
+    }
+
+    //advance physics simulation by exactly one step
+    this->physicsEngine.dynamicsWorld->stepSimulation(this->fixedStep, 0);
+
+    this->currentCameraPos = this->camera.getBodyCameraPos();
+    this->targets.record(this->tickCount);
+    this->tickCount++;
+}
+
+void GameCore::startNewGame()
+{
+    this->score = 0;
+    this->totalShots = 0;
+    this->gameTimer = GAME_TIME;
+    this->playing = true;
+    this->targets.spawnAll();
+}
+
+void GameCore::endGame()
+{
+    this->playing = false;
+    this->targets.disableAll();
+}
+
+bool GameCore::hitScanShoot()
+{
+    this->totalShots++;
+
+    //use raycasting to find if a target was hit
+    btVector3 btFrom(this->camera.Position.x, this->camera.Position.y, this->camera.Position.z);
+    glm::vec3 rayEnd = this->camera.Position + (this->camera.Front * 200.0f);
+    btVector3 btTo(rayEnd.x, rayEnd.y, rayEnd.z);
+
+    //the static geometry doesn't move, it is tested in the current world. The ray skips the player and the targets,
+    //the broadphase filters them before the narrowphase
+    btCollisionWorld::ClosestRayResultCallback res(btFrom, btTo);
+    res.m_collisionFilterGroup = COL_RAY;
+    res.m_collisionFilterMask = COL_HITSCAN_MASK & ~COL_TARGET;
+    this->physicsEngine.dynamicsWorld->rayTest(btFrom, btTo, res);
+
+    //the targets are tested in their rewound state and must be closer than the geometry
+    int hit = this->targets.rayTest(btFrom, btTo, res.m_closestHitFraction, this->presentedTick, this->presentedAlpha);
+
+    //target hit response
+    if (hit < 0)
+        return false;
+
+    if (this->onTargetHit)
+        this->onTargetHit(this->targets.position[hit]);
+    this->targets.hit(hit);
+    this->score++;
+    return true;
+}
+
+//spawn region given by the map, the cells where a target would touch the map are discarded. Must run after createMap and before the targets are added to the world
+void GameCore::buildSpawnVolume()
+{
+    float clearance = glm::max(TARGET_SIZE.x, glm::max(TARGET_SIZE.y, TARGET_SIZE.z));
+    this->spawnVolume.build(this->physicsEngine, this->scene.spawnMin, this->scene.spawnMax, SPAWN_CELL_SIZE, clearance);
+}
+
+//Move by setting the camera's rigigidBody linear velocity, y is taken from existing velocity to allow jumping with addForce
+void GameCore::player_movement(const PlayerInput& input)
+{
+    btVector3 direction = btVector3(0, this->camera.playerBody->getLinearVelocity().getY(), 0);
+    if(this->camera.isJumping)
+    {
+        if (this->currentCameraPos.y <= 1.8) this->camera.isJumping = false;
+    }
+    if(input.forward)
+        direction += btVector3(this->camera.WorldFront.x * VELOCITY, this->camera.WorldFront.y, this->camera.WorldFront.z * VELOCITY);
+    if(input.backward)
+        direction += btVector3(-this->camera.WorldFront.x * VELOCITY, this->camera.WorldFront.y, -this->camera.WorldFront.z * VELOCITY);
+    if(input.left)
+        direction += btVector3(-this->camera.Right.x * VELOCITY, this->camera.WorldFront.y, -this->camera.Right.z * VELOCITY);
+    if(input.right)
+        direction += btVector3(this->camera.Right.x * VELOCITY, this->camera.WorldFront.y, this->camera.Right.z * VELOCITY);
+
+    this->camera.playerBody->setLinearVelocity(direction);
+}
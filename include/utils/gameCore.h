@@ -0,0 +1,111 @@
+//game state and simulation tick, independent from the window and the renderer
+
+#ifndef GAME_CORE_H
+#define GAME_CORE_H
+
+#include <functional>
+
+//only used for the GL types of the camera, the core never calls GL
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "camera.h"
+#include "physics.h"
+#include "random.h"
+#include "scene.h"
+#include "spawnVolume.h"
+#include "targetManager.h"
+
+#define VELOCITY 5
+#define GAME_TIME 30.0f
+//default rate of the fixed simulation step, in Hz
+#define DEFAULT_TICK_RATE 120.0f
+//maximum number of fixed steps in a frame, after a longer frame the remaining time is dropped
+#define DEFAULT_MAX_SUBSTEPS 8
+//targets alive at the same time, 1 is the classic drill, more make a gridshot drill
+#define DEFAULT_TARGET_COUNT 1
+
+const glm::vec3 TARGET_SIZE = glm::vec3(0.5f, 0.5f, 0.5f);
+const glm::vec3 PLAYER_START_POSITION = glm::vec3(0.0f, 1.7f, 9.0f);
+
+//input of the player for one tick, filled by the window callbacks or by a script
+struct PlayerInput
+{
+    bool forward, backward, left, right;
+    bool jump;
+    bool shoot;
+    //mouse offsets, passed to Camera::ProcessMouseMovement
+    float lookX, lookY;
+};
+
+class GameCore
+{
+public:
+    Physics physicsEngine;
+    Camera camera;
+    //targets of the drill, the renderer draws the non inactive ones at their renderPosition
+    TargetManager targets;
+    //static geometry of the map, the colliders of the physics world and the objects drawn by the renderer
+    Scene scene;
+
+    //game state variables
+    int score, totalShots;
+    bool playing;
+    float gameTimer;
+
+    //called with the target position when it is hit (e.g. to spawn particles)
+    std::function<void(glm::vec3)> onTargetHit;
+
+    //random is used for the target positions and models, the simulation advances in steps of 1/tickRate seconds.
+    //More than one physics thread selects the multithreaded Bullet world, targetCount targets are alive at the same time.
+    //The map is loaded by the caller, so the games running in parallel (e.g. the headless sessions) share one load
+    GameCore(Random& random, const Scene& scene, float tickRate = DEFAULT_TICK_RATE, int maxSubSteps = DEFAULT_MAX_SUBSTEPS,
+        int physicsThreads = 1, int targetCount = DEFAULT_TARGET_COUNT);
+    ~GameCore();
+    GameCore(const GameCore& copy) = delete;
+    GameCore& operator=(const GameCore& copy) = delete;
+
+    //advance the game by the time of a frame: camera rotation and shots are applied right away, then the simulation runs
+    //as many fixed steps as the accumulated time allows and the camera and target are interpolated between the last two
+    void update(float frameTime, const PlayerInput& input);
+    //one fixed step of the simulation: movement, match state and physics
+    void tick(const PlayerInput& input);
+
+    float getFixedStep() { return this->fixedStep; };
+
+    //reset game variables and spawn all the targets
+    void startNewGame();
+    //move the target rigidbodies outside the scene and reset their state
+    void endGame();
+    //shoot along the camera front, returns true if a target was hit.
+    //The targets are rewound to the state of the last presented frame, the one the player is aiming at
+    bool hitScanShoot();
+
+    //number of fixed steps run so far
+    int getTickCount() { return this->tickCount; };
+
+private:
+    Random& random;
+
+    float fixedStep;
+    int maxSubSteps;
+    //simulated time not yet consumed by a fixed step
+    double accumulator;
+
+    //camera positions before and after the last fixed step
+    glm::vec3 previousCameraPos, currentCameraPos;
+
+    //valid target spawn cells, built once from the static map
+    SpawnVolume spawnVolume;
+
+    //the tick (plus interpolation factor) of the last state given to the renderer
+    int tickCount;
+    int presentedTick;
+    float presentedAlpha;
+
+    void createMap();
+    void buildSpawnVolume();
+    void player_movement(const PlayerInput& input);
+};
+
+#endif
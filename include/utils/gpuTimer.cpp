@@ -0,0 +1,71 @@
+#include "gpuTimer.h"
+
+GpuTimer::GpuTimer()
+    : current(0)
+{
+    glGenQueries(GPU_TIMER_LATENCY * ZONE_COUNT * 2, &this->queries[0][0][0]);
+    for (int i = 0; i < GPU_TIMER_LATENCY; i++)
+    {
+        this->pending[i] = false;
+        this->frames[i] = 0;
+        this->lastQuery[i] = 0;
+        for (int zone = 0; zone < ZONE_COUNT; zone++)
+            this->used[i][zone] = false;
+    }
+}
+
+GpuTimer::~GpuTimer()
+{
+    glDeleteQueries(GPU_TIMER_LATENCY * ZONE_COUNT * 2, &this->queries[0][0][0]);
+}
+
+void GpuTimer::beginZone(int zone)
+{
+    glQueryCounter(this->queries[this->current][zone][0], GL_TIMESTAMP);
+    this->lastQuery[this->current] = this->queries[this->current][zone][0];
+}
+
+void GpuTimer::endZone(int zone)
+{
+    glQueryCounter(this->queries[this->current][zone][1], GL_TIMESTAMP);
+    this->lastQuery[this->current] = this->queries[this->current][zone][1];
+    this->used[this->current][zone] = true;
+}
+
+void GpuTimer::endFrame(Profiler& profiler)
+{
+    this->frames[this->current] = profiler.getFrame();
+    this->pending[this->current] = true;
+    this->current = (this->current + 1) % GPU_TIMER_LATENCY;
+
+    //the next set of queries is the oldest one in flight, read it before reusing it
+    int oldest = this->current;
+    if (!this->pending[oldest])
+        return;
+    this->pending[oldest] = false;
+
+    //the timestamps are written in the order they are issued, if the last one is ready all of them are
+    GLuint last = this->lastQuery[oldest];
+    this->lastQuery[oldest] = 0;
+    if (last == 0)
+        return;
+
+    GLint available = 0;
+    glGetQueryObjectiv(last, GL_QUERY_RESULT_AVAILABLE, &available);
+
+    float times[ZONE_COUNT] = {};
+    for (int zone = 0; zone < ZONE_COUNT; zone++)
+    {
+        if (available && this->used[oldest][zone])
+        {
+            GLuint64 start, end;
+            glGetQueryObjectui64v(this->queries[oldest][zone][0], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(this->queries[oldest][zone][1], GL_QUERY_RESULT, &end);
+            times[zone] = (float)((end - start) / 1.0e6);
+        }
+        this->used[oldest][zone] = false;
+    }
+
+    if (available)
+        profiler.setGpuTimes(this->frames[oldest], times);
+}
@@ -0,0 +1,45 @@
+/*
+GpuTimer class
+- GPU time of the profiler zones, measured with timestamp queries around the GL commands of each zone
+- the queries of a frame are read GPU_TIMER_LATENCY frames later, when the GPU is done with them, so reading never stalls
+  the pipeline. A frame whose queries are still not ready is dropped
+
+The times are handed to the Profiler, next to the CPU times of the same frame.
+*/
+
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/glad.h>
+
+#include "profiler.h"
+
+//frames in flight before the queries of a frame are read
+#define GPU_TIMER_LATENCY 4
+
+class GpuTimer
+{
+public:
+    //needs a current GL context
+    GpuTimer();
+    ~GpuTimer();
+    GpuTimer(const GpuTimer& copy) = delete;
+    GpuTimer& operator=(const GpuTimer& copy) = delete;
+
+    //timestamps around the GL commands of a zone, the zones can be nested. A zone entered twice in a frame keeps the last time
+    void beginZone(int zone);
+    void endZone(int zone);
+    //close the queries of the current frame of the profiler and give it the times of the oldest frame in flight
+    void endFrame(Profiler& profiler);
+
+private:
+    GLuint queries[GPU_TIMER_LATENCY][ZONE_COUNT][2];
+    bool used[GPU_TIMER_LATENCY][ZONE_COUNT];
+    //last query issued in each frame, the zones are nested so it is not the end of the last zone index
+    GLuint lastQuery[GPU_TIMER_LATENCY];
+    uint64_t frames[GPU_TIMER_LATENCY];
+    bool pending[GPU_TIMER_LATENCY];
+    int current;
+};
+
+#endif
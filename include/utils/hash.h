@@ -0,0 +1,24 @@
+//64 bit FNV-1a hash, used to key and check the cooked asset files
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ull
+#define FNV_PRIME 0x100000001B3ull
+
+//pass the result as hash to continue hashing more data
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+#endif
@@ -0,0 +1,94 @@
+#include "jobSystem.h"
+
+JobSystem::JobSystem(int workers)
+    : stopping(false)
+{
+    if (workers <= 0)
+    {
+        int hardwareThreads = (int)std::thread::hardware_concurrency();
+        workers = (hardwareThreads > 1) ? hardwareThreads - 1 : 1;
+    }
+
+    for (int i = 0; i < workers; i++)
+        this->workers.emplace_back(&JobSystem::workerLoop, this);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->queueMutex);
+        this->stopping = true;
+    }
+    this->queueCondition.notify_all();
+
+    for (std::thread& worker : this->workers)
+        worker.join();
+}
+
+void JobSystem::Run(std::function<void()> job, JobCounter& counter)
+{
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(this->queueMutex);
+        this->queue.push_back(Job{ std::move(job), &counter });
+    }
+    this->queueCondition.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+    while (!counter.done())
+    {
+        // help with the queued jobs instead of sleeping, this also avoids deadlocks when a job waits on other jobs
+        if (!this->tryRunJob())
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::ParallelFor(int count, int chunkSize, const std::function<void(int, int)>& task)
+{
+    JobCounter counter;
+    for (int begin = 0; begin < count; begin += chunkSize)
+    {
+        int end = (begin + chunkSize < count) ? begin + chunkSize : count;
+        this->Run([&task, begin, end]() { task(begin, end); }, counter);
+    }
+    this->Wait(counter);
+}
+
+void JobSystem::workerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(this->queueMutex);
+            this->queueCondition.wait(lock, [this]() { return this->stopping || !this->queue.empty(); });
+            if (this->stopping && this->queue.empty())
+                return;
+            job = std::move(this->queue.front());
+            this->queue.pop_front();
+        }
+        this->execute(job);
+    }
+}
+
+bool JobSystem::tryRunJob()
+{
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(this->queueMutex);
+        if (this->queue.empty())
+            return false;
+        job = std::move(this->queue.front());
+        this->queue.pop_front();
+    }
+    this->execute(job);
+    return true;
+}
+
+void JobSystem::execute(Job& job)
+{
+    job.task();
+    job.counter->pending.fetch_sub(1, std::memory_order_release);
+}
@@ -0,0 +1,70 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of jobs still running in a group, a thread waiting on it helps executing queued jobs
+struct JobCounter
+{
+    std::atomic<int> pending{0};
+
+    bool done() { return this->pending.load(std::memory_order_acquire) == 0; }
+};
+
+// A small pool of worker threads consuming a shared job queue.
+// Jobs are grouped by a JobCounter so the caller can wait for a whole batch.
+class JobSystem
+{
+public:
+    // 0 workers means one less than the hardware threads (at least one)
+    JobSystem(int workers = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem& copy) = delete;
+    JobSystem& operator=(const JobSystem& copy) = delete;
+
+    int WorkerCount() { return (int)this->workers.size(); }
+
+    // queues a job, counter is incremented now and decremented when the job is done
+    void Run(std::function<void()> job, JobCounter& counter);
+    // blocks until all the jobs of the counter are done, running queued jobs in the meantime
+    void Wait(JobCounter& counter);
+    // runs task(begin, end) on consecutive chunks of [0, count), the calling thread takes part in the work
+    void ParallelFor(int count, int chunkSize, const std::function<void(int, int)>& task);
+
+private:
+    struct Job
+    {
+        std::function<void()> task;
+        JobCounter* counter;
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<Job> queue;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    bool stopping;
+
+    void workerLoop();
+    bool tryRunJob();
+    void execute(Job& job);
+};
+
+// runs task over [0, count) in chunks, on the job system if given or serially on the calling thread otherwise
+inline void ParallelFor(JobSystem* jobs, int count, int chunkSize, const std::function<void(int, int)>& task)
+{
+    if (jobs)
+    {
+        jobs->ParallelFor(count, chunkSize, task);
+        return;
+    }
+    for (int begin = 0; begin < count; begin += chunkSize)
+        task(begin, (begin + chunkSize < count) ? begin + chunkSize : count);
+}
+
+#endif
@@ -0,0 +1,147 @@
+#include "mappedFile.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+//temporary name unique to this writer: the process id and a counter of the writes of the process
+static std::string temporaryPath(const char* path)
+{
+    static std::atomic<unsigned> writes(0);
+#ifdef _WIN32
+    unsigned long process = GetCurrentProcessId();
+#else
+    unsigned long process = (unsigned long)getpid();
+#endif
+    return std::string(path) + ".tmp" + std::to_string(process) + "." + std::to_string(writes++);
+}
+
+bool writeFileReplace(const char* path, const void* data, size_t size)
+{
+    std::string temporary = temporaryPath(path);
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (!file)
+        return false;
+    bool written = fwrite(data, 1, size, file) == size;
+    written = (fclose(file) == 0) && written;
+
+    //the rename replaces the directory entry, the mappings of the old file stay valid
+#ifdef _WIN32
+    written = written && MoveFileExA(temporary.c_str(), path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    written = written && rename(temporary.c_str(), path) == 0;
+#endif
+    if (!written)
+        remove(temporary.c_str());
+    return written;
+}
+
+MappedFile::MappedFile()
+    : view(NULL), length(0)
+#ifdef _WIN32
+    , fileHandle(NULL), mappingHandle(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    this->close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* path)
+{
+    this->close();
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!view)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    this->fileHandle = file;
+    this->mappingHandle = mapping;
+    this->view = (const uint8_t*)view;
+    this->length = (size_t)size.QuadPart;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (!this->view)
+        return;
+
+    UnmapViewOfFile(this->view);
+    CloseHandle((HANDLE)this->mappingHandle);
+    CloseHandle((HANDLE)this->fileHandle);
+    this->view = NULL;
+    this->length = 0;
+}
+
+#else
+
+bool MappedFile::open(const char* path)
+{
+    this->close();
+
+    int file = ::open(path, O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        ::close(file);
+        return false;
+    }
+
+    void* view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    //the mapping keeps the file referenced
+    ::close(file);
+    if (view == MAP_FAILED)
+        return false;
+
+    this->view = (const uint8_t*)view;
+    this->length = (size_t)info.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (!this->view)
+        return;
+
+    munmap((void*)this->view, this->length);
+    this->view = NULL;
+    this->length = 0;
+}
+
+#endif
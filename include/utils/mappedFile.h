@@ -0,0 +1,46 @@
+/*
+MappedFile class
+- read-only memory mapping of a whole file (mmap, or a file mapping object on Windows)
+- the cooked asset files are used in place from the mapping, the pages are read by the OS when touched
+- the cooked files are written with writeFileReplace, so a mapping never sees a partially written file
+
+The platform headers are only included by mappedFile.cpp, AimMap.cpp must not see windows.h.
+*/
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile& copy) = delete;
+    MappedFile& operator=(const MappedFile& copy) = delete;
+
+    //map the file, returns false if it doesn't exist, is empty or can't be mapped
+    bool open(const char* path);
+    void close();
+
+    bool isOpen() { return this->view != NULL; };
+    //the mapping is page aligned
+    const uint8_t* data() { return this->view; };
+    size_t size() { return this->length; };
+
+private:
+    const uint8_t* view;
+    size_t length;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+//write size bytes to a temporary file next to path, then rename it over path. Another process (or thread) mapping path
+//keeps the old file, or maps the complete new one. Returns false, leaving path untouched, if anything fails
+bool writeFileReplace(const char* path, const void* data, size_t size);
+
+#endif
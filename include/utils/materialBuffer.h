@@ -0,0 +1,87 @@
+/*
+MaterialBuffer class
+- uniform buffer with the material of the next draws, bound once to MATERIAL_BLOCK_BINDING
+- a material change is a single upload of the whole block instead of one glUniform call per field, and drawing again
+  with the same material uploads nothing
+
+Used by the programs declaring MaterialBlock (shadows.frag compiled with MATERIAL_UBO).
+*/
+
+#pragma once
+
+#include <cstring>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "material.h"
+#include "uniformTable.h"
+
+//std140 layout of MaterialBlock, each vec3 is aligned to 16 bytes and the nested structs start at multiples of 16
+struct MaterialBlock
+{
+    glm::vec3 colorAmbient;
+    float pad0;
+    glm::vec3 colorDiffuse;
+    float pad1;
+    glm::vec3 colorSpecular;
+    float colorShininess;
+    float lightAmbient;
+    float lightDiffuse;
+    float lightSpecular;
+    float pad2;
+    float alpha;
+    float pad3[3];
+};
+static_assert(sizeof(MaterialBlock) == 80, "MaterialBlock must match the std140 layout of the shader block");
+
+class MaterialBuffer
+{
+public:
+    //needs a current GL context
+    MaterialBuffer()
+    {
+        memset(&this->current, 0, sizeof(this->current));
+        glGenBuffers(1, &this->UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(MaterialBlock), &this->current, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, this->UBO);
+        this->uploaded = false;
+    }
+
+    ~MaterialBuffer()
+    {
+        glDeleteBuffers(1, &this->UBO);
+    }
+
+    MaterialBuffer(const MaterialBuffer& copy) = delete;
+    MaterialBuffer& operator=(const MaterialBuffer& copy) = delete;
+
+    void upload(const Material& material)
+    {
+        MaterialBlock block = {};
+        block.colorAmbient = material.Color.ambient;
+        block.colorDiffuse = material.Color.diffuse;
+        block.colorSpecular = material.Color.specular;
+        block.colorShininess = material.Color.shininess;
+        block.lightAmbient = material.Light.ambient;
+        block.lightDiffuse = material.Light.diffuse;
+        block.lightSpecular = material.Light.specular;
+        block.alpha = material.alpha;
+
+        if (this->uploaded && memcmp(&block, &this->current, sizeof(block)) == 0)
+            return;
+
+        this->current = block;
+        this->uploaded = true;
+        glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(MaterialBlock), &this->current);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+private:
+    GLuint UBO;
+    MaterialBlock current;
+    bool uploaded;
+};
@@ -53,6 +53,8 @@ public:
     vector<GLuint> indices;
     // VAO
     GLuint VAO;
+    // number of indices drawn, the vectors are empty for a mesh uploaded from raw buffers
+    GLsizei indexCount;
 
     // We want Mesh to be a move-only class. We delete copy constructor and copy assignment
     // see:
@@ -70,7 +72,13 @@ public:
     Mesh(vector<Vertex>& vertices, vector<GLuint>& indices) noexcept
         : vertices(std::move(vertices)), indices(std::move(indices))
     {
-        this->setupMesh();
+        this->setupMesh(this->vertices.data(), this->vertices.size(), this->indices.data(), this->indices.size());
+    }
+
+    // Constructor from raw buffers (e.g. a cooked mesh mapped in memory): the data is uploaded to the GPU and not kept
+    Mesh(const Vertex* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount) noexcept
+    {
+        this->setupMesh(vertices, vertexCount, indices, indexCount);
     }
 
     // We implement a user-defined move constructor and move assignment
@@ -88,7 +96,7 @@ public:
     Mesh(Mesh&& move) noexcept
         // Calls move for both vectors, which internally consists of a simple pointer swap between the new instance and the source one.
         : vertices(std::move(move.vertices)), indices(std::move(move.indices)),
-        VAO(move.VAO), VBO(move.VBO), EBO(move.EBO)
+        VAO(move.VAO), indexCount(move.indexCount), VBO(move.VBO), EBO(move.EBO)
     {
         move.VAO = 0; // We *could* set VBO and EBO to 0 too,
         // but since we bring all the 3 values around we can use just one of them to check ownership of the 3 resources.
@@ -105,6 +113,7 @@ public:
             vertices = std::move(move.vertices);
             indices = std::move(move.indices);
             VAO = move.VAO;
+            indexCount = move.indexCount;
             VBO = move.VBO;
             EBO = move.EBO;
 
@@ -132,11 +141,32 @@ public:
         // VAO is made "active"
         glBindVertexArray(this->VAO);
         // rendering of data in the VAO
-        glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, this->indexCount, GL_UNSIGNED_INT, 0);
         // VAO is "detached"
         glBindVertexArray(0);
     }
 
+    // rendering of several instances of the mesh in a single draw call
+    void DrawInstanced(GLsizei instances)
+    {
+        glBindVertexArray(this->VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, this->indexCount, GL_UNSIGNED_INT, 0, instances);
+        glBindVertexArray(0);
+    }
+
+    // per instance float attribute (1 to 4 components) read from another buffer, advanced once per instance.
+    // The locations from 5 are free, 0-4 are the vertex attributes set up by setupMesh
+    void setInstanceAttribute(GLuint location, GLint components, GLuint buffer, GLsizei stride, size_t offset)
+    {
+        glBindVertexArray(this->VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, components, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offset);
+        glVertexAttribDivisor(location, 1);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
 private:
 
     // VBO and EBO
@@ -148,8 +178,10 @@ private:
     // https://learnopengl.com/#!Getting-started/Hello-Triangle
     // (in different parts of the page), or here:
     // http://www.informit.com/articles/article.aspx?p=1377833&seqNum=8
-    void setupMesh()
+    void setupMesh(const Vertex* vertices, size_t vertexCount, const GLuint* indices, size_t indexCount)
     {
+        this->indexCount = (GLsizei)indexCount;
+
         // we create the buffers
         glGenVertexArrays(1, &this->VAO);
         glGenBuffers(1, &this->VBO);
@@ -159,10 +191,10 @@ private:
         glBindVertexArray(this->VAO);
         // we copy data in the VBO - we must set the data dimension, and the pointer to the structure cointaining the data
         glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-        glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(Vertex), &this->vertices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Vertex), vertices, GL_STATIC_DRAW);
         // we copy data in the EBO - we must set the data dimension, and the pointer to the structure cointaining the data
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indices.size() * sizeof(GLuint), &this->indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(GLuint), indices, GL_STATIC_DRAW);
 
         // we set in the VAO the pointers to the different vertex attributes (with the relative offsets inside the data structure)
         // vertex positions
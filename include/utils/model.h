@@ -2,6 +2,9 @@
 Model class
 - OBJ models loading using Assimp library
 - the class converts data from Assimp data structure to a OpenGL-compatible data structure (Mesh class in mesh_v1.h)
+- the converted buffers are cooked next to the model (see cookedMesh.h), the next loads upload them from the mapped cooked
+  file without running Assimp
+- the loading is split in read, with no GL calls so it can run on a worker thread, and upload on the GL thread
 
 N.B. 1)
 Model and Mesh classes follow RAII principles (https://en.cppreference.com/w/cpp/language/raii).
@@ -23,6 +26,9 @@ Universita' degli Studi di Milano
 #pragma once
 using namespace std;
 
+#include <cstring>
+#include <iostream>
+
 // we use GLM data structures to convert data in the Assimp data structures in a data structures suited for VBO, VAO and EBO buffers
 #include <glm/glm.hpp>
 
@@ -34,6 +40,27 @@ using namespace std;
 // we include the Mesh class, which manages the "OpenGL side" (= creation and allocation of VBO, VAO, EBO buffers) of the loading of models
 #include <utils/mesh.h>
 
+#include <utils/cookedMesh.h>
+#include <utils/hash.h>
+#include <utils/mappedFile.h>
+
+// Assimp post processing of the imported models, part of the key of the cooked meshes
+#define MODEL_IMPORT_FLAGS (aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace)
+
+static_assert(sizeof(Vertex) == 14 * sizeof(float), "changing Vertex needs a new COOKED_MESH_VERSION");
+
+// CPU side of a model: the buffers of its meshes, imported by Assimp or in the mapped cooked file.
+// Filled by Model::read on any thread, then given to Model::upload on the GL thread
+struct ModelData
+{
+    // imported meshes
+    vector<vector<Vertex>> vertices;
+    vector<vector<GLuint>> indices;
+    // cooked meshes, uploaded straight from the mapping
+    MappedFile cooked;
+    vector<CookedMeshRange> ranges;
+};
+
 /////////////////// MODEL class ///////////////////////
 class Model
 {
@@ -70,7 +97,57 @@ public:
     // because we are not writing a user-defined destructor.
     Model(const string& path)
     {
-        this->loadModel(path);
+        ModelData data;
+        Model::read(path, data);
+        this->upload(data);
+    }
+
+    // empty model, its meshes are created later by upload (e.g. after a read on a worker thread, see AssetLoader)
+    Model() {}
+
+    //////////////////////////////////////////
+
+    // CPU side of the loading, no GL calls so it can run on any thread: the model is read from its cooked meshes if
+    // they are up to date, otherwise it is imported with Assimp and cooked. Returns false if it can't be loaded
+    static bool read(const string& path, ModelData& data)
+    {
+        string cookedPath = path + COOKED_MESH_EXTENSION;
+
+        // the key of the cooked meshes: the source file, mapped to hash it without a copy, and the import flags
+        MappedFile source;
+        if (!source.open(path.c_str()))
+        {
+            // a model can be shipped cooked only
+            if (Model::readCooked(cookedPath, NULL, data))
+                return true;
+            cout << "ERROR::MODEL:: failed to open " << path << endl;
+            return false;
+        }
+        uint64_t sourceHash = fnv1a(source.data(), source.size());
+        source.close();
+
+        if (Model::readCooked(cookedPath, &sourceHash, data))
+            return true;
+
+        if (!Model::import(path, data))
+            return false;
+        Model::cook(cookedPath, sourceHash, data);
+        return true;
+    }
+
+    // GL side of the loading: the meshes are created from the buffers read by read
+    void upload(ModelData& data)
+    {
+        if (data.cooked.isOpen())
+        {
+            for (const CookedMeshRange& range : data.ranges)
+                this->meshes.emplace_back((const Vertex*)(data.cooked.data() + range.vertexOffset), range.vertexCount,
+                    (const GLuint*)(data.cooked.data() + range.indexOffset), range.indexCount);
+            return;
+        }
+
+        for (size_t i = 0; i < data.vertices.size(); i++)
+            this->meshes.emplace_back(data.vertices[i].data(), data.vertices[i].size(), data.indices[i].data(), data.indices[i].size());
     }
 
     //////////////////////////////////////////
@@ -82,14 +159,21 @@ public:
             this->meshes[i].Draw();
     }
 
+    // instanced rendering of all the meshes, the per instance attributes must be set on each mesh (Mesh::setInstanceAttribute)
+    void DrawInstanced(GLsizei instances)
+    {
+        for(GLuint i = 0; i < this->meshes.size(); i++)
+            this->meshes[i].DrawInstanced(instances);
+    }
+
     //////////////////////////////////////////
 
 
 private:
 
     //////////////////////////////////////////
-    // loading of the model using Assimp library. Nodes are processed to build a vector of Mesh class instances
-    void loadModel(string path)
+    // loading of the model using Assimp library. Nodes are processed to fill the buffers of each mesh
+    static bool import(const string& path, ModelData& data)
     {
         // loading using Assimp
         // N.B.: it is possible to set, if needed, some operations to be performed by Assimp after the loading.
@@ -97,23 +181,116 @@ private:
         // VERY IMPORTANT: calculation of Tangents and Bitangents is possible only if the model has Texture Coordinates
         // If they are not present, the calculation is skipped (but no error is provided in the following checks!)
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace);
+        const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
 
         // check for errors (see comment above)
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
+            return false;
         }
 
         // we start the recursive processing of nodes in the Assimp data structure
-        this->processNode(scene->mRootNode, scene);
+        Model::processNode(scene->mRootNode, scene, data);
+        return true;
+    }
+
+    //////////////////////////////////////////
+    // buffers of the meshes in the mapped cooked file. False if it is missing, invalid, or was cooked from another
+    // source (sourceHash) or with other import flags. Without sourceHash any source is accepted
+    static bool readCooked(const string& path, const uint64_t* sourceHash, ModelData& data)
+    {
+        MappedFile& file = data.cooked;
+        if (!file.open(path.c_str()))
+            return false;
+
+        const CookedMeshHeader* header = (const CookedMeshHeader*)file.data();
+        bool current = file.size() >= sizeof(CookedMeshHeader) && header->magic == COOKED_MESH_MAGIC && header->version == COOKED_MESH_VERSION;
+        if (!current)
+            cout << "Cooked model " << path << " has an old or unknown format" << endl;
+        if (!current || header->importFlags != (uint32_t)(MODEL_IMPORT_FLAGS) || (sourceHash && header->sourceHash != *sourceHash))
+        {
+            file.close();
+            return false;
+        }
+
+        bool valid = header->fileSize == file.size() && header->rangeOffset % 16 == 0
+            && header->rangeOffset + (uint64_t)header->meshCount * sizeof(CookedMeshRange) <= file.size()
+            && header->checksum == fnv1a(file.data() + sizeof(CookedMeshHeader), file.size() - sizeof(CookedMeshHeader));
+
+        const CookedMeshRange* ranges = valid ? (const CookedMeshRange*)(file.data() + header->rangeOffset) : NULL;
+        for (uint32_t i = 0; valid && i < header->meshCount; i++)
+        {
+            valid = ranges[i].vertexOffset % 16 == 0 && ranges[i].indexOffset % 16 == 0
+                && ranges[i].vertexOffset + (uint64_t)ranges[i].vertexCount * sizeof(Vertex) <= file.size()
+                && ranges[i].indexOffset + (uint64_t)ranges[i].indexCount * sizeof(GLuint) <= file.size();
+        }
+        if (!valid)
+        {
+            cout << "Cooked model " << path << " is corrupted" << endl;
+            file.close();
+            return false;
+        }
+
+        data.ranges.assign(ranges, ranges + header->meshCount);
+        return true;
+    }
+
+    //////////////////////////////////////////
+    // write the buffers of the imported meshes in the cooked format
+    static bool cook(const string& path, uint64_t sourceHash, const ModelData& data)
+    {
+        size_t meshCount = data.vertices.size();
+
+        CookedMeshHeader header = {};
+        header.magic = COOKED_MESH_MAGIC;
+        header.version = COOKED_MESH_VERSION;
+        header.sourceHash = sourceHash;
+        header.importFlags = (uint32_t)(MODEL_IMPORT_FLAGS);
+        header.meshCount = (uint32_t)meshCount;
+        header.rangeOffset = sizeof(CookedMeshHeader);
+
+        // every array starts at a multiple of 16 bytes
+        vector<CookedMeshRange> ranges(meshCount);
+        size_t offset = header.rangeOffset + ranges.size() * sizeof(CookedMeshRange);
+        for (size_t i = 0; i < meshCount; i++)
+        {
+            offset = (offset + 15) & ~(size_t)15;
+            ranges[i].vertexOffset = (uint32_t)offset;
+            ranges[i].vertexCount = (uint32_t)data.vertices[i].size();
+            offset = (offset + ranges[i].vertexCount * sizeof(Vertex) + 15) & ~(size_t)15;
+            ranges[i].indexOffset = (uint32_t)offset;
+            ranges[i].indexCount = (uint32_t)data.indices[i].size();
+            offset += ranges[i].indexCount * sizeof(GLuint);
+        }
+        header.fileSize = (uint32_t)offset;
+
+        vector<uint8_t> bytes(offset, 0);
+        if (!ranges.empty())
+            memcpy(bytes.data() + header.rangeOffset, ranges.data(), ranges.size() * sizeof(CookedMeshRange));
+        for (size_t i = 0; i < meshCount; i++)
+        {
+            if (ranges[i].vertexCount > 0)
+                memcpy(bytes.data() + ranges[i].vertexOffset, data.vertices[i].data(), ranges[i].vertexCount * sizeof(Vertex));
+            if (ranges[i].indexCount > 0)
+                memcpy(bytes.data() + ranges[i].indexOffset, data.indices[i].data(), ranges[i].indexCount * sizeof(GLuint));
+        }
+        header.checksum = fnv1a(bytes.data() + sizeof(CookedMeshHeader), bytes.size() - sizeof(CookedMeshHeader));
+        memcpy(bytes.data(), &header, sizeof(CookedMeshHeader));
+
+        // the models folder could be read only, the model is still usable without its cooked form
+        if (!writeFileReplace(path.c_str(), bytes.data(), bytes.size()))
+        {
+            cout << "Failed to write the cooked model " << path << endl;
+            return false;
+        }
+        return true;
     }
 
     //////////////////////////////////////////
 
     // Recursive processing of nodes of Assimp data structure
-    void processNode(aiNode* node, const aiScene* scene)
+    static void processNode(aiNode* node, const aiScene* scene, ModelData& data)
     {
         // we process each mesh inside the current node
         for(GLuint i = 0; i < node->mNumMeshes; i++)
@@ -122,29 +299,28 @@ private:
             // "Scene" contains all the data. Class node is used only to point to one or more mesh inside the scene and to maintain informations on relations between nodes
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
             // we start processing of the Assimp mesh using processMesh method.
-            // the result (an istance of the Mesh class) is added to the vector
-            // we use emplace_back instead as push_back, so to have the instance created directly in the
-            // vector memory, without the creation of a temp copy.
-            // https://en.cppreference.com/w/cpp/container/vector/emplace_back
-            this->meshes.emplace_back(processMesh(mesh));
+            // the result (the buffers of an "OpenGL mesh") is added to the model data
+            Model::processMesh(mesh, data);
         }
         // we then recursively process each of the children nodes
         for(GLuint i = 0; i < node->mNumChildren; i++)
         {
-            this->processNode(node->mChildren[i], scene);
+            Model::processNode(node->mChildren[i], scene, data);
         }
 
     }
 
     //////////////////////////////////////////
 
-    // Processing of the Assimp mesh in order to obtain an "OpenGL mesh"
-    // = we create and allocate the buffers used to send mesh data to the GPU
-    Mesh processMesh(aiMesh* mesh)
+    // Processing of the Assimp mesh in order to obtain the buffers of an "OpenGL mesh"
+    // = the vertices and indices later sent to the GPU by upload
+    static void processMesh(aiMesh* mesh, ModelData& data)
     {
         // data structures for vertices and indices of vertices (for faces)
-        vector<Vertex> vertices;
-        vector<GLuint> indices;
+        data.vertices.emplace_back();
+        data.indices.emplace_back();
+        vector<Vertex>& vertices = data.vertices.back();
+        vector<GLuint>& indices = data.indices.back();
 
         for(GLuint i = 0; i < mesh->mNumVertices; i++)
         {
@@ -200,7 +376,5 @@ private:
                 indices.emplace_back(face.mIndices[j]);
         }
 
-        // we return an instance of the Mesh class created using the vertices and faces data structures we have created above.
-        return Mesh(vertices, indices);
     }
 };
@@ -0,0 +1,176 @@
+#include "particle.h"
+
+ParticleStore::ParticleStore(int capacity)
+    : count(0), capacity(capacity)
+{
+    this->paddedCapacity = ((capacity + PARTICLE_SIMD_WIDTH - 1) / PARTICLE_SIMD_WIDTH) * PARTICLE_SIMD_WIDTH;
+
+    this->posX = allocParticleStream<float>(this->paddedCapacity);
+    this->posY = allocParticleStream<float>(this->paddedCapacity);
+    this->posZ = allocParticleStream<float>(this->paddedCapacity);
+    this->velX = allocParticleStream<float>(this->paddedCapacity);
+    this->velY = allocParticleStream<float>(this->paddedCapacity);
+    this->velZ = allocParticleStream<float>(this->paddedCapacity);
+    this->gravityPercent = allocParticleStream<float>(this->paddedCapacity);
+    this->lifeLength = allocParticleStream<float>(this->paddedCapacity);
+    this->elapsedTime = allocParticleStream<float>(this->paddedCapacity);
+    this->scale = allocParticleStream<float>(this->paddedCapacity);
+    this->cameraDistance = allocParticleStream<float>(this->paddedCapacity);
+    this->color = allocParticleStream<GLubyte>(this->paddedCapacity * 4);
+}
+
+ParticleStore::~ParticleStore()
+{
+    freeParticleStream(this->posX);
+    freeParticleStream(this->posY);
+    freeParticleStream(this->posZ);
+    freeParticleStream(this->velX);
+    freeParticleStream(this->velY);
+    freeParticleStream(this->velZ);
+    freeParticleStream(this->gravityPercent);
+    freeParticleStream(this->lifeLength);
+    freeParticleStream(this->elapsedTime);
+    freeParticleStream(this->scale);
+    freeParticleStream(this->cameraDistance);
+    freeParticleStream(this->color);
+}
+
+//init a new particle at the tail of the alive range and return its index,
+//if the store is full the first particle is overridden
+int ParticleStore::spawn(glm::vec3 position, glm::vec3 velocity, float gravity, float lifeLength, float scale)
+{
+    int i = (this->count < this->capacity) ? this->count++ : 0;
+
+    this->posX[i] = position.x;
+    this->posY[i] = position.y;
+    this->posZ[i] = position.z;
+    this->velX[i] = velocity.x;
+    this->velY[i] = velocity.y;
+    this->velZ[i] = velocity.z;
+    this->gravityPercent[i] = gravity;
+    this->lifeLength[i] = lifeLength;
+    this->elapsedTime[i] = 0.0f;
+    this->scale[i] = scale;
+    this->cameraDistance[i] = -1.0f;
+
+    return i;
+}
+
+//copy the survivors of [begin, end) in dst, remap holds the destination index of each particle (-1 for the dead ones).
+//Each stream is copied in its own loop so the chunk is read sequentially
+void ParticleStore::compactInto(ParticleStore& dst, const int* remap, int begin, int end)
+{
+    float* const srcStreams[] = { this->posX, this->posY, this->posZ, this->velX, this->velY, this->velZ,
+        this->gravityPercent, this->lifeLength, this->elapsedTime, this->scale, this->cameraDistance };
+    float* const dstStreams[] = { dst.posX, dst.posY, dst.posZ, dst.velX, dst.velY, dst.velZ,
+        dst.gravityPercent, dst.lifeLength, dst.elapsedTime, dst.scale, dst.cameraDistance };
+
+    for(int s=0; s<11; s++)
+    {
+        const float* src = srcStreams[s];
+        float* out = dstStreams[s];
+        for(int i=begin; i<end; i++)
+            if (remap[i] >= 0) out[remap[i]] = src[i];
+    }
+
+    for(int i=begin; i<end; i++)
+        if (remap[i] >= 0) memcpy(&dst.color[4*remap[i]], &this->color[4*i], 4 * sizeof(GLubyte));
+}
+
+//scalar version of the update, used for the particles that don't fill a whole vector
+inline bool integrateParticle(ParticleStore& store, int i, float deltaTime, glm::vec3 cameraPos)
+{
+    store.velY[i] -= GRAVITY * store.gravityPercent[i] * deltaTime;
+    store.posX[i] += store.velX[i] * deltaTime;
+    store.posY[i] += store.velY[i] * deltaTime;
+    store.posZ[i] += store.velZ[i] * deltaTime;
+    store.elapsedTime[i] += deltaTime;
+
+    float dx = store.posX[i] - cameraPos.x;
+    float dy = store.posY[i] - cameraPos.y;
+    float dz = store.posZ[i] - cameraPos.z;
+    store.cameraDistance[i] = dx*dx + dy*dy + dz*dz;
+
+    return store.elapsedTime[i] < store.lifeLength[i];
+}
+
+#if PARTICLE_SIMD_WIDTH == 8
+typedef __m256 pfloat;
+inline pfloat pLoad(const float* p) { return _mm256_load_ps(p); }
+inline void pStore(float* p, pfloat v) { _mm256_store_ps(p, v); }
+inline pfloat pSet(float v) { return _mm256_set1_ps(v); }
+inline pfloat pAdd(pfloat a, pfloat b) { return _mm256_add_ps(a, b); }
+inline pfloat pSub(pfloat a, pfloat b) { return _mm256_sub_ps(a, b); }
+inline pfloat pMul(pfloat a, pfloat b) { return _mm256_mul_ps(a, b); }
+inline pfloat pLess(pfloat a, pfloat b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline int pMoveMask(pfloat mask) { return _mm256_movemask_ps(mask); }
+#elif PARTICLE_SIMD_WIDTH == 4
+typedef __m128 pfloat;
+inline pfloat pLoad(const float* p) { return _mm_load_ps(p); }
+inline void pStore(float* p, pfloat v) { _mm_store_ps(p, v); }
+inline pfloat pSet(float v) { return _mm_set1_ps(v); }
+inline pfloat pAdd(pfloat a, pfloat b) { return _mm_add_ps(a, b); }
+inline pfloat pSub(pfloat a, pfloat b) { return _mm_sub_ps(a, b); }
+inline pfloat pMul(pfloat a, pfloat b) { return _mm_mul_ps(a, b); }
+inline pfloat pLess(pfloat a, pfloat b) { return _mm_cmplt_ps(a, b); }
+inline int pMoveMask(pfloat mask) { return _mm_movemask_ps(mask); }
+#endif
+
+int integrateParticles(ParticleStore& store, int begin, int end, float deltaTime, glm::vec3 cameraPos, int* deadIndices)
+{
+    int deadCount = 0;
+    int i = begin;
+
+#if PARTICLE_SIMD_WIDTH > 1
+    const pfloat dt = pSet(deltaTime);
+    const pfloat gravityStep = pSet(GRAVITY * deltaTime);
+    const pfloat camX = pSet(cameraPos.x);
+    const pfloat camY = pSet(cameraPos.y);
+    const pfloat camZ = pSet(cameraPos.z);
+
+    //scalar steps until the streams are aligned to the vector width
+    for(; i < end && i % PARTICLE_SIMD_WIDTH != 0; i++)
+    {
+        if (!integrateParticle(store, i, deltaTime, cameraPos))
+            deadIndices[deadCount++] = i;
+    }
+
+    for(; i + PARTICLE_SIMD_WIDTH <= end; i += PARTICLE_SIMD_WIDTH)
+    {
+        pfloat vy = pSub(pLoad(&store.velY[i]), pMul(gravityStep, pLoad(&store.gravityPercent[i])));
+        pfloat px = pAdd(pLoad(&store.posX[i]), pMul(pLoad(&store.velX[i]), dt));
+        pfloat py = pAdd(pLoad(&store.posY[i]), pMul(vy, dt));
+        pfloat pz = pAdd(pLoad(&store.posZ[i]), pMul(pLoad(&store.velZ[i]), dt));
+        pfloat elapsed = pAdd(pLoad(&store.elapsedTime[i]), dt);
+
+        pStore(&store.velY[i], vy);
+        pStore(&store.posX[i], px);
+        pStore(&store.posY[i], py);
+        pStore(&store.posZ[i], pz);
+        pStore(&store.elapsedTime[i], elapsed);
+
+        pfloat dx = pSub(px, camX);
+        pfloat dy = pSub(py, camY);
+        pfloat dz = pSub(pz, camZ);
+        pStore(&store.cameraDistance[i], pAdd(pAdd(pMul(dx, dx), pMul(dy, dy)), pMul(dz, dz)));
+
+        //append the lanes that just died to the dead list
+        int mask = ~pMoveMask(pLess(elapsed, pLoad(&store.lifeLength[i]))) & ((1 << PARTICLE_SIMD_WIDTH) - 1);
+        while (mask)
+        {
+            int lane = 0;
+            while (!(mask & (1 << lane))) lane++;
+            deadIndices[deadCount++] = i + lane;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for(; i < end; i++)
+    {
+        if (!integrateParticle(store, i, deltaTime, cameraPos))
+            deadIndices[deadCount++] = i;
+    }
+
+    return deadCount;
+}
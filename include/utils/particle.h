@@ -1,79 +1,78 @@
 #ifndef Particle_header
 #define Particle_header
 
+#include <cstring>
+#include <new>
 #include <glm/glm.hpp>
-#include <glfw/glfw3.h>
+#include <glad/glad.h>
+
+//vector width used by the particle update kernel
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define PARTICLE_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define PARTICLE_SIMD_WIDTH 4
+#else
+    #define PARTICLE_SIMD_WIDTH 1
+#endif
 
 #define GRAVITY 50
+#define MAX_PARTICLES 10000
+#define PARTICLE_STREAM_ALIGNMENT 32
 
-//Class describing the single particle attributes
-class Particle
+//Structure of arrays holding the attributes of all the particles, each attribute is a separate stream
+//so the update kernel only touches the data it needs and can process several particles per instruction.
+//Alive particles are kept dense in [0, count): new ones are appended at the tail and the survivors of each update
+//are compacted, keeping their relative order, into a second store
+struct ParticleStore
 {
-private:
-    glm::vec3 position;
-    glm::vec3 velocity;
-    float gravityPercent;
-    float lifeLength;
-    float rotation;
-    float scale;
-    float cameraDistance;
-
-    float elapsedTime;
-
-public:
-
-    unsigned char r,g,b,a;
-
-    Particle(glm::vec3 &position, glm::vec3 velocity, float gravity, float lifeLength, float rotation, float scale);
-    ~Particle();
-    Particle();
+    float* posX;
+    float* posY;
+    float* posZ;
+    float* velX;
+    float* velY;
+    float* velZ;
+    float* gravityPercent;
+    float* lifeLength;
+    float* elapsedTime;
+    float* scale;
+    float* cameraDistance;
+    //RGBA packed in the same byte order used by the GPU color buffer
+    GLubyte* color;
 
-    //update particle velocity, position and elapsed time values, returns false if the particle elapsed time is over it's lifetime
-    bool update(GLfloat deltaTime)
-    {
-        this->velocity.y -= GRAVITY * this->gravityPercent * deltaTime;
-        glm::vec3 delta = this->velocity * deltaTime;
-        this->position += delta;
-        this->elapsedTime += deltaTime;
+    int count;
+    int capacity;
 
-        return this->elapsedTime < this->lifeLength;
-    }
+    ParticleStore(int capacity);
+    ~ParticleStore();
+    ParticleStore(const ParticleStore& copy) = delete;
+    ParticleStore& operator=(const ParticleStore& copy) = delete;
 
-    //operator < implementation to allow sorting by camera distance
-    bool operator<(const  Particle &other)
-    {
-        return this->cameraDistance > other.cameraDistance;
-    }
-
-    glm::vec3 getPosition() { return this->position; };
-    float getRotation() { return this->rotation; };
-    float getScale() { return this->scale; };
-    bool isAlive() { return this->elapsedTime < this->lifeLength; };
-    float getCameraDistance() { return this->cameraDistance; };
-    void setcameraDistance(float newdist) { this->cameraDistance = newdist; };
-    void setlifeLength(float length) { this->lifeLength = length; };
-    void setPosition(glm::vec3 newPosition) { this->position = newPosition; };
-    void setVelocity(glm::vec3 newVelocity) { this->velocity = newVelocity; };
-    void setScale(float newScale) { this->scale = newScale; };
-    void resetElapsedTime() { this->elapsedTime = 0.0f; };
+    int spawn(glm::vec3 position, glm::vec3 velocity, float gravity, float lifeLength, float scale);
+    void compactInto(ParticleStore& dst, const int* remap, int begin, int end);
 
+private:
+    //each stream is padded to a multiple of the vector width
+    int paddedCapacity;
 };
 
-Particle::Particle(glm::vec3 &position, glm::vec3 velocity, float gravityPercent, float lifeLength, float rotation, float scale)
-    : position(position), velocity(velocity), gravityPercent(gravityPercent), lifeLength(lifeLength), rotation(rotation), scale(scale)
-{
-    this->elapsedTime = 0.0f;
-    this->cameraDistance = -1.0f;
-    
-}
-Particle::Particle()
-    : position(glm::vec3(0.0f)), velocity(glm::vec3(0.0f)), gravityPercent(0.3f), lifeLength(0.0f), rotation(0.0f), scale(1.0f)
+//aligned allocation of a single attribute stream
+template <typename T>
+T* allocParticleStream(int size)
 {
-    this->elapsedTime = 0.0f;
-    this->cameraDistance = -1.0f;
+    return static_cast<T*>(::operator new(size * sizeof(T), std::align_val_t(PARTICLE_STREAM_ALIGNMENT)));
 }
-Particle::~Particle()
+
+template <typename T>
+void freeParticleStream(T* stream)
 {
+    ::operator delete(stream, std::align_val_t(PARTICLE_STREAM_ALIGNMENT));
 }
 
-#endif
\ No newline at end of file
+//Integrate-and-cull kernel: advances the alive particles in [begin, end) by deltaTime and writes the indices of the
+//ones that died during this step in deadIndices (in ascending order), returns how many died.
+//Since the alive range is dense there is no per-particle branch in the vector loop
+int integrateParticles(ParticleStore& store, int begin, int end, float deltaTime, glm::vec3 cameraPos, int* deadIndices);
+
+#endif
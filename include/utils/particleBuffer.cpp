@@ -0,0 +1,32 @@
+#include "particleBuffer.h"
+
+ParticleBufferRing::ParticleBufferRing(ParticleBufferBackend* backend, int capacity, int frames)
+    : backend(backend), capacity(capacity), frames(frames), frameIndex(0)
+{
+    this->backend->allocate(this->frames * this->capacity * 4 * sizeof(GLfloat), this->frames * this->capacity * 4 * sizeof(GLubyte),
+        &this->posSizeData, &this->colorData);
+}
+
+ParticleBufferRegion ParticleBufferRing::begin()
+{
+    int slot = this->currentSlot();
+    this->backend->wait(slot);
+
+    ParticleBufferRegion region;
+    region.firstInstance = slot * this->capacity;
+    region.posSize = this->posSizeData + region.firstInstance * 4;
+    region.color = this->colorData + region.firstInstance * 4;
+    return region;
+}
+
+void ParticleBufferRing::commit(int count)
+{
+    size_t first = this->currentSlot() * this->capacity;
+    this->backend->commit(first * 4 * sizeof(GLfloat), count * 4 * sizeof(GLfloat), first * 4 * sizeof(GLubyte), count * 4 * sizeof(GLubyte));
+}
+
+void ParticleBufferRing::end()
+{
+    this->backend->fence(this->currentSlot());
+    this->frameIndex++;
+}
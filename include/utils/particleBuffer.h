@@ -0,0 +1,259 @@
+#ifndef ParticleBuffer_header
+#define ParticleBuffer_header
+
+#include <cstddef>
+#include <vector>
+#include <glad/glad.h>
+
+//number of frames the instance buffers are split in, the CPU writes one while the GPU can still read the others
+#define PARTICLE_BUFFER_FRAMES 3
+//how long to wait on a fence before flushing again (nanoseconds)
+#define PARTICLE_FENCE_TIMEOUT 1000000
+
+//Storage of the particle instance buffers (position+size and color). The ring buffer logic only talks to this
+//interface, so it can run on the GL implementations or on the CPU-only one
+class ParticleBufferBackend
+{
+public:
+    virtual ~ParticleBufferBackend() {}
+
+    //allocate both buffers and return the CPU pointers the simulation writes into
+    virtual void allocate(size_t posSizeBytes, size_t colorBytes, GLfloat** posSizeData, GLubyte** colorData) = 0;
+    //wait until the GPU finished reading the frame slot
+    virtual void wait(int slot) = 0;
+    //make the written ranges visible to the GPU
+    virtual void commit(size_t posSizeOffset, size_t posSizeBytes, size_t colorOffset, size_t colorBytes) = 0;
+    //mark the end of the GPU commands reading the frame slot
+    virtual void fence(int slot) = 0;
+
+    virtual GLuint posSizeBuffer() { return 0; };
+    virtual GLuint colorBuffer() { return 0; };
+};
+
+//Write pointers of the current frame slot
+struct ParticleBufferRegion
+{
+    GLfloat* posSize;
+    GLubyte* color;
+    //index of the first instance of the slot inside the whole buffers
+    int firstInstance;
+};
+
+//Ring of PARTICLE_BUFFER_FRAMES sub-ranges, each big enough for all the particles, guarded by one fence each
+class ParticleBufferRing
+{
+private:
+    ParticleBufferBackend* backend;
+    int capacity;
+    int frames;
+    int frameIndex;
+    GLfloat* posSizeData;
+    GLubyte* colorData;
+
+public:
+    ParticleBufferRing(ParticleBufferBackend* backend, int capacity, int frames = PARTICLE_BUFFER_FRAMES);
+
+    int currentSlot() { return this->frameIndex % this->frames; };
+
+    //wait for the slot of this frame to be free and return where to write the instances
+    ParticleBufferRegion begin();
+    //publish the first count instances written in the current slot
+    void commit(int count);
+    //fence the draw reading the current slot and move to the next one
+    void end();
+};
+
+//Persistently and coherently mapped buffers (GL 4.4 buffer storage), the simulation writes directly in GPU visible memory
+class PersistentParticleBuffers : public ParticleBufferBackend
+{
+private:
+    GLuint posBuffer, colBuffer;
+    GLsync fences[PARTICLE_BUFFER_FRAMES];
+
+public:
+    PersistentParticleBuffers()
+        : posBuffer(0), colBuffer(0)
+    {
+        for(int i=0; i<PARTICLE_BUFFER_FRAMES; i++)
+            this->fences[i] = 0;
+    }
+
+    ~PersistentParticleBuffers()
+    {
+        for(int i=0; i<PARTICLE_BUFFER_FRAMES; i++)
+            if (this->fences[i]) glDeleteSync(this->fences[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, this->posBuffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, this->colBuffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glDeleteBuffers(1, &this->posBuffer);
+        glDeleteBuffers(1, &this->colBuffer);
+    }
+
+    void allocate(size_t posSizeBytes, size_t colorBytes, GLfloat** posSizeData, GLubyte** colorData)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glGenBuffers(1, &this->posBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, this->posBuffer);
+        glBufferStorage(GL_ARRAY_BUFFER, posSizeBytes, NULL, flags);
+        *posSizeData = (GLfloat*)glMapBufferRange(GL_ARRAY_BUFFER, 0, posSizeBytes, flags);
+
+        glGenBuffers(1, &this->colBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, this->colBuffer);
+        glBufferStorage(GL_ARRAY_BUFFER, colorBytes, NULL, flags);
+        *colorData = (GLubyte*)glMapBufferRange(GL_ARRAY_BUFFER, 0, colorBytes, flags);
+    }
+
+    void wait(int slot)
+    {
+        GLsync fence = this->fences[slot];
+        if (!fence)
+            return;
+
+        GLbitfield waitFlags = 0;
+        while (true)
+        {
+            GLenum result = glClientWaitSync(fence, waitFlags, PARTICLE_FENCE_TIMEOUT);
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+                break;
+            //make sure the fence gets to the GPU before waiting again
+            waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        }
+        glDeleteSync(fence);
+        this->fences[slot] = 0;
+    }
+
+    //coherent mapping, nothing to do
+    void commit(size_t, size_t, size_t, size_t) {}
+
+    void fence(int slot)
+    {
+        this->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    GLuint posSizeBuffer() { return this->posBuffer; };
+    GLuint colorBuffer() { return this->colBuffer; };
+};
+
+//Fallback for contexts without buffer storage (e.g. GL 4.1): the simulation writes in CPU memory
+//and only the used range of the slot is uploaded, the ring keeps the upload away from the ranges the GPU is reading
+class StreamingParticleBuffers : public ParticleBufferBackend
+{
+private:
+    GLuint posBuffer, colBuffer;
+    std::vector<GLfloat> posSizeStaging;
+    std::vector<GLubyte> colorStaging;
+
+public:
+    StreamingParticleBuffers()
+        : posBuffer(0), colBuffer(0)
+    {
+    }
+
+    ~StreamingParticleBuffers()
+    {
+        glDeleteBuffers(1, &this->posBuffer);
+        glDeleteBuffers(1, &this->colBuffer);
+    }
+
+    void allocate(size_t posSizeBytes, size_t colorBytes, GLfloat** posSizeData, GLubyte** colorData)
+    {
+        this->posSizeStaging.resize(posSizeBytes / sizeof(GLfloat));
+        this->colorStaging.resize(colorBytes / sizeof(GLubyte));
+
+        glGenBuffers(1, &this->posBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, this->posBuffer);
+        glBufferData(GL_ARRAY_BUFFER, posSizeBytes, NULL, GL_STREAM_DRAW);
+
+        glGenBuffers(1, &this->colBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, this->colBuffer);
+        glBufferData(GL_ARRAY_BUFFER, colorBytes, NULL, GL_STREAM_DRAW);
+
+        *posSizeData = this->posSizeStaging.data();
+        *colorData = this->colorStaging.data();
+    }
+
+    void wait(int) {}
+
+    void commit(size_t posSizeOffset, size_t posSizeBytes, size_t colorOffset, size_t colorBytes)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, this->posBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, posSizeOffset, posSizeBytes, (GLubyte*)this->posSizeStaging.data() + posSizeOffset);
+        glBindBuffer(GL_ARRAY_BUFFER, this->colBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, colorOffset, colorBytes, this->colorStaging.data() + colorOffset);
+    }
+
+    void fence(int) {}
+
+    GLuint posSizeBuffer() { return this->posBuffer; };
+    GLuint colorBuffer() { return this->colBuffer; };
+};
+
+//CPU-only backend that simulates a GPU lagging gpuLatency frames behind, to exercise the ring and fence logic
+//without a GL context. Fences are signaled once gpuLatency newer fences have been issued
+class CpuParticleBuffers : public ParticleBufferBackend
+{
+public:
+    std::vector<GLfloat> posSizeMemory;
+    std::vector<GLubyte> colorMemory;
+    int gpuLatency;
+
+    //statistics
+    int stalls;
+    int commits;
+    size_t committedBytes;
+    //slots in the order they were waited on, and the ranges of the last commit
+    std::vector<int> waits;
+    size_t lastPosSizeOffset, lastPosSizeBytes, lastColorOffset, lastColorBytes;
+
+    CpuParticleBuffers(int gpuLatency = 1)
+        : gpuLatency(gpuLatency), stalls(0), commits(0), committedBytes(0),
+        lastPosSizeOffset(0), lastPosSizeBytes(0), lastColorOffset(0), lastColorBytes(0), fenceCount(0)
+    {
+        for(int i=0; i<PARTICLE_BUFFER_FRAMES; i++)
+            this->fenceSerial[i] = -1;
+    }
+
+    void allocate(size_t posSizeBytes, size_t colorBytes, GLfloat** posSizeData, GLubyte** colorData)
+    {
+        this->posSizeMemory.resize(posSizeBytes / sizeof(GLfloat));
+        this->colorMemory.resize(colorBytes / sizeof(GLubyte));
+        *posSizeData = this->posSizeMemory.data();
+        *colorData = this->colorMemory.data();
+    }
+
+    //true if the simulated GPU is still reading the slot
+    bool busy(int slot) { return this->fenceSerial[slot] >= 0 && this->fenceCount - this->fenceSerial[slot] < this->gpuLatency; };
+    //true if the slot has a fence not waited on yet
+    bool fenced(int slot) { return this->fenceSerial[slot] >= 0; };
+
+    void wait(int slot)
+    {
+        if (this->busy(slot))
+            this->stalls++;
+        this->fenceSerial[slot] = -1;
+        this->waits.push_back(slot);
+    }
+
+    void commit(size_t posSizeOffset, size_t posSizeBytes, size_t colorOffset, size_t colorBytes)
+    {
+        this->commits++;
+        this->committedBytes += posSizeBytes + colorBytes;
+        this->lastPosSizeOffset = posSizeOffset;
+        this->lastPosSizeBytes = posSizeBytes;
+        this->lastColorOffset = colorOffset;
+        this->lastColorBytes = colorBytes;
+    }
+
+    void fence(int slot)
+    {
+        this->fenceSerial[slot] = ++this->fenceCount;
+    }
+
+private:
+    int fenceCount;
+    int fenceSerial[PARTICLE_BUFFER_FRAMES];
+};
+
+#endif
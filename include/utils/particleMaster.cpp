@@ -0,0 +1,263 @@
+#include "particleMaster.h"
+
+ParticleMaster::ParticleMaster(Shader particleShader, int maxParticles, JobSystem* jobs, ParticleBufferBackend* buffers)
+    : MaxParticles(maxParticles), jobs(jobs), storeA(maxParticles), storeB(maxParticles), current(&storeA), next(&storeB),
+    particleRenderer(particleShader, maxParticles, buffers), blending(PARTICLE_BLEND_ALPHA), deadIndices(maxParticles),
+    chunkAlive(maxParticles / PARTICLE_JOB_CHUNK + 1), chunkOffset(maxParticles / PARTICLE_JOB_CHUNK + 1), remap(maxParticles),
+    order(maxParticles), orderCount(0), sortKeys(maxParticles), tmpOrder(maxParticles), tmpKeys(maxParticles), aliveParticles(0)
+{
+    this->snapshot.count = 0;
+    this->snapshot.additive = false;
+}
+
+ParticleMaster::~ParticleMaster()
+{
+    if (this->jobs)
+        this->jobs->Wait(this->simulationJob);
+}
+
+//quantized sort key of a squared camera distance: positive float bits are monotonic,
+//they are inverted so that an ascending sort puts the farthest particles first
+inline uint32_t particleSortKey(float distance)
+{
+    uint32_t bits;
+    memcpy(&bits, &distance, sizeof(bits));
+    return ~(bits >> 8) & 0xFFFFFF;
+}
+
+//move the requested particles in the store, appending them at the end of the order list
+void ParticleMaster::addSpawns()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->spawnMutex);
+        std::swap(this->pendingSpawns, this->spawnBatch);
+    }
+
+    ParticleStore& store = *this->current;
+    for(const ParticleSpawn& spawn : this->spawnBatch)
+    {
+        //when the store is full the overridden particle is already in the order list
+        bool full = store.count == store.capacity;
+        int particleIndex = store.spawn(spawn.position, spawn.velocity, 0.3f, 3.0f, spawn.scale);
+        if (!full)
+            this->order[this->orderCount++] = particleIndex;
+
+        store.color[4*particleIndex+0] = 51;
+        store.color[4*particleIndex+1] = 204;
+        store.color[4*particleIndex+2] = 51;
+        store.color[4*particleIndex+3] = spawn.alpha;
+    }
+    this->spawnBatch.clear();
+}
+
+//stream compaction of the survivors: each chunk counted its alive particles while integrating, an exclusive
+//prefix sum of the counts gives where each chunk writes, then all the chunks scatter their survivors in parallel
+void ParticleMaster::compact(int count)
+{
+    int chunks = (count + PARTICLE_JOB_CHUNK - 1) / PARTICLE_JOB_CHUNK;
+
+    int total = 0;
+    for(int k=0; k<chunks; k++)
+    {
+        this->chunkOffset[k] = total;
+        total += this->chunkAlive[k];
+    }
+
+    ParallelFor(this->jobs, count, PARTICLE_JOB_CHUNK, [this](int begin, int end)
+    {
+        int k = begin / PARTICLE_JOB_CHUNK;
+        const int* dead = &this->deadIndices[begin];
+        int deadCount = (end - begin) - this->chunkAlive[k];
+        int newIndex = this->chunkOffset[k];
+        int d = 0;
+        for(int i=begin; i<end; i++)
+        {
+            if (d < deadCount && dead[d] == i)
+            {
+                this->remap[i] = -1;
+                d++;
+            }
+            else
+                this->remap[i] = newIndex++;
+        }
+        this->current->compactInto(*this->next, this->remap.data(), begin, end);
+    });
+
+    this->next->count = total;
+    std::swap(this->current, this->next);
+}
+
+//bring the order of the last frame up to date with the compaction,
+//relative order of the survivors is kept so the list stays almost sorted
+void ParticleMaster::updateOrder()
+{
+    int n = 0;
+    for(int k=0; k<this->orderCount; k++)
+    {
+        int newIndex = this->remap[this->order[k]];
+        if (newIndex >= 0)
+            this->order[n++] = newIndex;
+    }
+    this->orderCount = n;
+}
+
+//insertion sort on the almost sorted list of the previous frame, gives up if it needs more than budget moves
+bool ParticleMaster::insertionSort(int count, int budget)
+{
+    uint32_t* keys = this->sortKeys.data();
+    int* values = this->order.data();
+
+    for(int i=1; i<count; i++)
+    {
+        uint32_t key = keys[i];
+        int value = values[i];
+        int j = i - 1;
+        while (j >= 0 && keys[j] > key)
+        {
+            keys[j+1] = keys[j];
+            values[j+1] = values[j];
+            j--;
+            if (--budget < 0)
+            {
+                //leave a valid permutation for the radix sort
+                keys[j+1] = key;
+                values[j+1] = value;
+                return false;
+            }
+        }
+        keys[j+1] = key;
+        values[j+1] = value;
+    }
+    return true;
+}
+
+//LSD radix sort of the 24 bit keys, 8 bits per pass
+void ParticleMaster::radixSort(int count)
+{
+    for(int shift=0; shift<24; shift+=8)
+    {
+        int histogram[256] = {0};
+        for(int i=0; i<count; i++)
+            histogram[(this->sortKeys[i] >> shift) & 0xFF]++;
+
+        int offset = 0;
+        for(int b=0; b<256; b++)
+        {
+            int size = histogram[b];
+            histogram[b] = offset;
+            offset += size;
+        }
+
+        for(int i=0; i<count; i++)
+        {
+            int dest = histogram[(this->sortKeys[i] >> shift) & 0xFF]++;
+            this->tmpKeys[dest] = this->sortKeys[i];
+            this->tmpOrder[dest] = this->order[i];
+        }
+
+        std::swap(this->sortKeys, this->tmpKeys);
+        std::swap(this->order, this->tmpOrder);
+    }
+}
+
+void ParticleMaster::SortParticles()
+{
+    int count = this->orderCount;
+    for(int k=0; k<count; k++)
+        this->sortKeys[k] = particleSortKey(this->current->cameraDistance[this->order[k]]);
+
+    //particles move little between frames, so the previous order is usually almost sorted
+    if (!this->insertionSort(count, count * INSERTION_SORT_BUDGET))
+        this->radixSort(count);
+}
+
+//one simulation step, runs on the job system and writes the sorted instances in region
+void ParticleMaster::Simulate(GLfloat deltaTime, glm::vec3 cameraPos, ParticleBufferRegion region, bool additive)
+{
+    this->addSpawns();
+
+    //integrate each chunk, dead particles of a chunk are listed at the start of its range of deadIndices
+    int count = this->current->count;
+    ParallelFor(this->jobs, count, PARTICLE_JOB_CHUNK, [this, deltaTime, cameraPos](int begin, int end)
+    {
+        int deadCount = integrateParticles(*this->current, begin, end, deltaTime, cameraPos, &this->deadIndices[begin]);
+        this->chunkAlive[begin / PARTICLE_JOB_CHUNK] = (end - begin) - deadCount;
+    });
+
+    this->compact(count);
+    this->updateOrder();
+
+    //to ensure correct blending, additive blending gives the same result in any order
+    if (!additive)
+        this->SortParticles();
+
+    //gather the alive particles straight into the instance buffers of this frame
+    const ParticleStore& store = *this->current;
+    ParallelFor(this->jobs, store.count, PARTICLE_JOB_CHUNK, [this, &store, region](int begin, int end)
+    {
+        for(int n=begin; n<end; n++)
+        {
+            int i = this->order[n];
+
+            region.posSize[4*n+0] = store.posX[i];
+            region.posSize[4*n+1] = store.posY[i];
+            region.posSize[4*n+2] = store.posZ[i];
+            region.posSize[4*n+3] = store.scale[i];
+
+            memcpy(&region.color[4*n], &store.color[4*i], 4 * sizeof(GLubyte));
+        }
+    });
+
+    this->snapshot.region = region;
+    this->snapshot.count = store.count;
+    this->snapshot.additive = additive;
+    this->aliveParticles.store(store.count, std::memory_order_relaxed);
+}
+
+void ParticleMaster::Update(GLfloat deltaTime, glm::mat4 viewMatrix)
+{
+    glm::vec3 cameraPos = glm::inverse(viewMatrix)[3];
+    bool additive = this->blending == PARTICLE_BLEND_ADDITIVE;
+
+    //the fence wait must happen on the thread owning the GL context
+    ParticleBufferRegion region = this->particleRenderer.beginFrame();
+
+    if (this->jobs)
+        this->jobs->Run([this, deltaTime, cameraPos, region, additive]() { this->Simulate(deltaTime, cameraPos, region, additive); }, this->simulationJob);
+    else
+        this->Simulate(deltaTime, cameraPos, region, additive);
+}
+
+void ParticleMaster::Render()
+{
+    if (this->jobs)
+        this->jobs->Wait(this->simulationJob);
+
+    this->particleRenderer.render(this->snapshot.count, this->snapshot.additive);
+}
+
+//queues a set number of particles in a 3D point with random velocity, they are added by the next simulation step
+void ParticleMaster::generateParticles(glm::vec3 origin)
+{
+    //random directions for the whole burst at once
+    Random& random = GameRandom();
+    glm::vec3 randomdirs[PARTICLES_PER_HIT];
+    random.inSphere(randomdirs, PARTICLES_PER_HIT);
+
+    float spread = 10.5f; //how far particles spread
+    glm::vec3 maindir = glm::vec3(0.0f, 3.0f, 0.0f); //direction bias for all particles generated
+
+    std::lock_guard<std::mutex> lock(this->spawnMutex);
+
+    for(int i=0; i<PARTICLES_PER_HIT; i++)
+    {
+        ParticleSpawn spawn;
+        spawn.position = origin;
+        spawn.velocity = maindir + randomdirs[i]*spread;
+        //random alpha
+        spawn.alpha = random.range(256) / 3;
+        spawn.scale = random.range(0.1f, 0.6f);
+
+        this->pendingSpawns.push_back(spawn);
+    }
+}
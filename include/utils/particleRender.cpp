@@ -0,0 +1,95 @@
+#include "particleRender.h"
+
+ParticleBufferBackend* createParticleBuffers()
+{
+    if (glBufferStorage != NULL)
+        return new PersistentParticleBuffers();
+    return new StreamingParticleBuffers();
+}
+
+//init needed buffers for rendering
+void ParticleRenderer::init()
+{
+    glGenVertexArrays(1, &this->quadVAO);
+    glBindVertexArray(this->quadVAO);
+
+    glGenBuffers(1, &this->BillboardVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->BillboardVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(this->vertices), this->vertices, GL_STATIC_DRAW);
+}
+
+ParticleRenderer::ParticleRenderer(Shader particleShader, int maxParticles, ParticleBufferBackend* backend) 
+    : MaxParticles(maxParticles), shader(particleShader), buffers(backend ? backend : createParticleBuffers()),
+    ring(this->buffers.get(), maxParticles)
+
+{
+    this->init();
+}
+
+//wait for the oldest frame slot to be free
+ParticleBufferRegion ParticleRenderer::beginFrame()
+{
+    this->region = this->ring.begin();
+    return this->region;
+}
+
+//render all particles in the scene, additive blending doesn't write depth so the draw order doesn't matter
+void ParticleRenderer::render(int particlesCount, bool additive)
+{
+    glBindVertexArray(this->quadVAO);
+    this->prepareForRender();
+
+    if (additive)
+    {
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+        glDepthMask(GL_FALSE);
+    }
+
+    glVertexAttribDivisor(0, 0); // same values for all particles (vertex data)
+    glVertexAttribDivisor(1, 1); // one value for each particle (position)
+    glVertexAttribDivisor(2, 1); // one value for each particle (color)
+
+    this->ring.commit(particlesCount);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, particlesCount);
+    this->ring.end();
+
+    if (additive)
+    {
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_TRUE);
+    }
+
+    this->endRender();
+}
+
+//bind necessary buffers
+void ParticleRenderer::prepareForRender()
+{
+    
+    this->shader.Use();
+    // vertex buffer
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, this->BillboardVBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+    // position and scale buffer, starting from the slot of this frame
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, this->buffers->posSizeBuffer());
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 0, (void*)(this->region.firstInstance * 4 * sizeof(GLfloat)));
+
+    // color buffer
+    glEnableVertexAttribArray(2);
+    glBindBuffer(GL_ARRAY_BUFFER, this->buffers->colorBuffer());
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (void*)(this->region.firstInstance * 4 * sizeof(GLubyte)));
+
+}
+
+void ParticleRenderer::endRender()
+{
+
+    glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
+    glDisableVertexAttribArray(2);
+    glBindVertexArray(0);
+
+}
@@ -4,6 +4,8 @@ Physics class:
 
 The class sets up the collision manager and the resolver of the constraints, using basic general-purposes methods provided by the library. Advanced and multithread methods are available, please consult Bullet documentation and examples
 
+The multithreaded world (dispatcher, solver pool and island manager running on the Bullet task scheduler) can be selected in the constructor, it needs Bullet built with BT_THREADSAFE=1
+
 createRigidBody method sets up a Box or Sphere Collision Shape. For other Shapes, you must extend the method.
 
 author: Davide Gadia
@@ -14,49 +16,257 @@ Universita' degli Studi di Milano
 */
 
 /*
-    extended to support more shapes
+    extended to support more shapes and the multithreaded world
 */
 #pragma once
 
+#include <iostream>
+#include <map>
+#include <vector>
+
 #include <bullet/btBulletDynamicsCommon.h>
+#include <bullet/BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <bullet/LinearMath/btThreads.h>
+
+#include "jobSystem.h"
+
+//rays tested by each job of a batched ray test
+#define RAY_BATCH_CHUNK 16
 
 //enum to identify the 2 considered Collision Shapes
 enum shapes{ BOX, SPHERE, CYLINDER, CAPSULE};
 
+//collision groups, above the ones reserved by Bullet (btBroadphaseProxy::CollisionFilterGroups).
+//Two bodies collide if each one has the group of the other in its mask, rays use the COL_RAY group
+enum collision_groups{
+    COL_PLAYER = 1 << 6,
+    COL_WORLD = 1 << 7,
+    COL_TARGET = 1 << 8,
+    COL_PROP = 1 << 9,
+    COL_RAY = 1 << 10
+};
+
+//the player is not hit by its own rays
+const int COL_PLAYER_MASK = COL_WORLD | COL_TARGET | COL_PROP;
+const int COL_WORLD_MASK = COL_PLAYER | COL_TARGET | COL_PROP | COL_RAY;
+const int COL_TARGET_MASK = COL_PLAYER | COL_WORLD | COL_PROP | COL_RAY;
+const int COL_PROP_MASK = COL_PLAYER | COL_WORLD | COL_TARGET | COL_PROP | COL_RAY;
+//what a hitscan ray can hit: targets, and the geometry that hides them
+const int COL_HITSCAN_MASK = COL_WORLD | COL_TARGET | COL_PROP;
+
+//result of one ray of a batched ray test
+struct RayHit
+{
+    const btCollisionObject* object; // closest body hit, NULL if the ray hit nothing
+    btVector3 point;
+    btVector3 normal;
+    btScalar fraction; // position of the hit along the ray, in [0, 1]
+};
+
+///////////////////  ShapeCache class ///////////////////////
+// Collision Shapes are immutable and can be shared by any number of bodies: the cache returns the same shape for
+// the same type and dimensions, and deletes it when the last body using it is destroyed
+class ShapeCache
+{
+public:
+    ~ShapeCache()
+    {
+        this->Clear();
+    }
+
+    // returns the shape for type and size, creating it the first time
+    btCollisionShape* acquire(int type, glm::vec3 size)
+    {
+        // only the dimensions used by the shape are part of the key
+        if (type == SPHERE)
+            size = glm::vec3(size.x, 0.0f, 0.0f);
+        else if (type == CAPSULE)
+            size = glm::vec3(size.x, size.y, 0.0f);
+        ShapeKey key = { type, size.x, size.y, size.z };
+
+        std::map<ShapeKey, CachedShape>::iterator it = this->shapes.find(key);
+        if (it != this->shapes.end())
+        {
+            it->second.references++;
+            return it->second.shape;
+        }
+
+        btCollisionShape* cShape = NULL;
+        // Box Collision shape
+        if (type == BOX)
+            cShape = new btBoxShape(btVector3(size.x,size.y,size.z));
+        // Sphere Collision Shape (in this case we consider only the first component)
+        else if (type == SPHERE)
+            cShape = new btSphereShape(size.x);
+        else if (type == CYLINDER)
+            cShape = new btCylinderShape(btVector3(size.x, size.y, size.z));
+        else if (type == CAPSULE)
+            cShape = new btCapsuleShape(size.x, size.y);
+
+        CachedShape cached = { cShape, 1 };
+        this->shapes[key] = cached;
+        this->keys[cShape] = key;
+        return cShape;
+    }
+
+    // a body doesn't use the shape anymore
+    void release(btCollisionShape* shape)
+    {
+        std::map<btCollisionShape*, ShapeKey>::iterator key = this->keys.find(shape);
+        if (key == this->keys.end())
+            return;
+
+        std::map<ShapeKey, CachedShape>::iterator it = this->shapes.find(key->second);
+        if (--it->second.references > 0)
+            return;
+
+        delete shape;
+        this->shapes.erase(it);
+        this->keys.erase(key);
+    }
+
+    // number of distinct shapes
+    int size() { return (int)this->shapes.size(); }
+
+    void Clear()
+    {
+        for (std::map<ShapeKey, CachedShape>::iterator it = this->shapes.begin(); it != this->shapes.end(); ++it)
+            delete it->second.shape;
+        this->shapes.clear();
+        this->keys.clear();
+    }
+
+private:
+    struct ShapeKey
+    {
+        int type;
+        float x, y, z;
+
+        bool operator<(const ShapeKey& other) const
+        {
+            if (this->type != other.type) return this->type < other.type;
+            if (this->x != other.x) return this->x < other.x;
+            if (this->y != other.y) return this->y < other.y;
+            return this->z < other.z;
+        }
+    };
+
+    struct CachedShape
+    {
+        btCollisionShape* shape;
+        int references;
+    };
+
+    std::map<ShapeKey, CachedShape> shapes;
+    std::map<btCollisionShape*, ShapeKey> keys;
+};
+
+// leaf test of a batched ray: the broadphase tree calls it for every proxy whose bounds the ray crosses, the proxies
+// passing the collision filter are tested against the exact shape, keeping the closest hit
+struct RayBatchLeafTest : public btDbvt::ICollide
+{
+    btTransform rayFrom, rayTo;
+    int group, mask;
+    btCollisionWorld::ClosestRayResultCallback result;
+
+    RayBatchLeafTest(const btVector3& from, const btVector3& to, int group, int mask)
+        : group(group), mask(mask), result(from, to)
+    {
+        this->rayFrom.setIdentity();
+        this->rayFrom.setOrigin(from);
+        this->rayTo.setIdentity();
+        this->rayTo.setOrigin(to);
+    }
+
+    void Process(const btDbvtNode* leaf)
+    {
+        btBroadphaseProxy* proxy = (btBroadphaseProxy*)leaf->data;
+        if (!(proxy->m_collisionFilterGroup & this->mask) || !(this->group & proxy->m_collisionFilterMask))
+            return;
+
+        // the tree is traversed with the full ray, skip the proxies behind the closest hit found so far
+        btScalar param = this->result.m_closestHitFraction;
+        btVector3 normal;
+        if (!btRayAabb(this->result.m_rayFromWorld, this->result.m_rayToWorld, proxy->m_aabbMin, proxy->m_aabbMax, param, normal))
+            return;
+
+        btCollisionObject* object = (btCollisionObject*)proxy->m_clientObject;
+        btCollisionWorld::rayTestSingle(this->rayFrom, this->rayTo, object, object->getCollisionShape(), object->getWorldTransform(), this->result);
+    }
+};
+
 ///////////////////  Physics class ///////////////////////
 class Physics
 {
 public:
 
     btDiscreteDynamicsWorld* dynamicsWorld; // the main physical simulation class
-    btAlignedObjectArray<btCollisionShape*> collisionShapes; // a vector for all the Collision Shapes of the scene
+    ShapeCache* collisionShapes; // shared cache of all the Collision Shapes of the scene (the copies of this class use the same one)
     btDefaultCollisionConfiguration* collisionConfiguration; // setup for the collision manager
     btCollisionDispatcher* dispatcher; // collision manager
     btBroadphaseInterface* overlappingPairCache; // method for the broadphase collision detection
-    btSequentialImpulseConstraintSolver* solver; // constraints solver
+    btConstraintSolver* solver; // constraints solver (a pool of solvers, one per thread, in the multithreaded world)
+    btConstraintSolver* solverMt; // multithreaded solver for the large islands, NULL in the single threaded world
+    bool multithreaded;
 
 
     //////////////////////////////////////////
     // constructor
     // we set all the classes needed for the physical simulation
-    Physics()
+    // with multithreaded = true the world runs on numThreads threads of the Bullet task scheduler (0 = all the available threads)
+    Physics(bool multithreaded = false, int numThreads = 0)
+        : collisionShapes(new ShapeCache()), solverMt(NULL), multithreaded(false)
     {
+        // the task scheduler is shared by all the multithreaded worlds, it is NULL if Bullet is not thread safe
+        if (multithreaded)
+        {
+            if (!btGetTaskScheduler())
+            {
+                btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+                if (scheduler)
+                    btSetTaskScheduler(scheduler);
+            }
+            btITaskScheduler* scheduler = btGetTaskScheduler();
+            if (scheduler)
+            {
+                int maxThreads = scheduler->getMaxNumThreads();
+                scheduler->setNumThreads((numThreads > 0 && numThreads < maxThreads) ? numThreads : maxThreads);
+                this->multithreaded = true;
+            }
+            else
+                std::cout << "Bullet is not built with BT_THREADSAFE, using the single threaded physics world" << std::endl;
+        }
+
         // Collision configuration, to be used by the collision detection class
         // collision configuration contains default setup for memory, collision setup. Advanced users can create their own configuration.
         this->collisionConfiguration = new btDefaultCollisionConfiguration();
 
-        // default collision dispatcher (=collision detection method). For parallel processing you can use a diffent dispatcher (see Extras/BulletMultiThreaded)
-        this->dispatcher = new btCollisionDispatcher(this->collisionConfiguration);
+        // default collision dispatcher (=collision detection method). The multithreaded one computes the pairs in parallel
+        if (this->multithreaded)
+            this->dispatcher = new btCollisionDispatcherMt(this->collisionConfiguration);
+        else
+            this->dispatcher = new btCollisionDispatcher(this->collisionConfiguration);
 
         // btDbvtBroadphase is a good general purpose broadphase. You can also try out btAxis3Sweep.
         this->overlappingPairCache = new btDbvtBroadphase();
 
         // we set a ODE solver, which considers forces, constraints, collisions etc., to calculate positions and rotations of the rigid bodies.
-        // the default constraint solver. For parallel processing you can use a different solver (see Extras/BulletMultiThreaded)
-        this->solver = new btSequentialImpulseConstraintSolver();
+        // the multithreaded world solves the islands in parallel with a pool of solvers, plus a multithreaded solver for the large islands
+        if (this->multithreaded)
+        {
+            this->solver = new btConstraintSolverPoolMt(btGetTaskScheduler()->getNumThreads());
+            this->solverMt = new btSequentialImpulseConstraintSolverMt();
+        }
+        else
+            this->solver = new btSequentialImpulseConstraintSolver();
 
-        //  DynamicsWorld is the main class for the physical simulation
-        this->dynamicsWorld = new btDiscreteDynamicsWorld(this->dispatcher,this->overlappingPairCache,this->solver,this->collisionConfiguration);
+        //  DynamicsWorld is the main class for the physical simulation, the multithreaded one uses btSimulationIslandManagerMt
+        if (this->multithreaded)
+            this->dynamicsWorld = new btDiscreteDynamicsWorldMt(this->dispatcher,this->overlappingPairCache,(btConstraintSolverPoolMt*)this->solver,this->solverMt,this->collisionConfiguration);
+        else
+            this->dynamicsWorld = new btDiscreteDynamicsWorld(this->dispatcher,this->overlappingPairCache,this->solver,this->collisionConfiguration);
 
         // we set the gravity force
         this->dynamicsWorld->setGravity(btVector3(0.0f,-9.82f,0.0f));
@@ -65,10 +275,13 @@ public:
     //////////////////////////////////////////
     // Method for the creation of a rigid body, based on a Box or Sphere Collision Shape
     // The Collision Shape is a reference solid that approximates the shape of the actual object of the scene. The Physical simulation is applied to these solids, and the rotations and positions of these solids are used on the real models.
-    btRigidBody* createRigidBody(int type, glm::vec3 pos, glm::vec3 size, glm::vec3 rot, float m, float friction , float restitution)
+    // group and mask are the collision filter of the body, the group is also saved as user index to know what kind of body a ray hit
+    btRigidBody* createRigidBody(int type, glm::vec3 pos, glm::vec3 size, glm::vec3 rot, float m, float friction , float restitution,
+        int group = COL_WORLD, int mask = COL_WORLD_MASK)
     {
 
-        btCollisionShape* cShape = NULL;
+        // bodies with the same type and dimensions share the Collision Shape
+        btCollisionShape* cShape = this->collisionShapes->acquire(type, size);
 
         // we convert the glm vector to a Bullet vector
         btVector3 position = btVector3(pos.x,pos.y,pos.z);
@@ -77,26 +290,6 @@ public:
         btQuaternion rotation;
         rotation.setEuler(rot.x,rot.y,rot.z);
 
-        // Box Collision shape
-        if (type == BOX)
-        {
-            // we convert the glm vector to a Bullet vector
-            btVector3 dim = btVector3(size.x,size.y,size.z);
-            // BoxShape
-            cShape = new btBoxShape(dim);
-        }
-        // Sphere Collision Shape (in this case we consider only the first component)
-        else if (type == SPHERE)
-            cShape = new btSphereShape(size.x);
-
-        else if (type == CYLINDER)
-            cShape = new btCylinderShape(btVector3(size.x, size.y, size.z));
-        else if (type == CAPSULE)
-            cShape = new btCapsuleShape(size.x, size.y);
-
-        // we add this Collision Shape to the vector
-        this->collisionShapes.push_back(cShape);
-
         // We set the initial transformations
         btTransform objTransform;
         objTransform.setIdentity();
@@ -134,14 +327,90 @@ public:
         // we create the rigid body
         btRigidBody* body = new btRigidBody(rbInfo);
 
+        body->setUserIndex(group);
+
         //add the body to the dynamics world
-        this->dynamicsWorld->addRigidBody(body);
+        this->dynamicsWorld->addRigidBody(body, group, mask);
 
         // the function returns a pointer to the created rigid body
         // in a standard simulation (e.g., only objects falling), it is not needed to have a reference to a single rigid body, but in some cases (e.g., the application of an impulse), it is needed.
         return body;
     }
 
+    //////////////////////////////////////////
+    // turn a body into a kinematic one, moved by writing its world transform. Its Motion State is deleted, so at every step
+    // the simulation reads the transform directly instead of calling the Motion State of each kinematic body
+    void setKinematic(btRigidBody* body)
+    {
+        btBroadphaseProxy* proxy = body->getBroadphaseHandle();
+        int group = proxy->m_collisionFilterGroup;
+        int mask = proxy->m_collisionFilterMask;
+
+        // the static flag is set when the body is added to the world, it must be removed to change it
+        this->dynamicsWorld->removeRigidBody(body);
+        delete body->getMotionState();
+        body->setMotionState(NULL);
+        body->setCollisionFlags((body->getCollisionFlags() & ~btCollisionObject::CF_STATIC_OBJECT) | btCollisionObject::CF_KINEMATIC_OBJECT);
+        body->setActivationState(DISABLE_DEACTIVATION);
+        this->dynamicsWorld->addRigidBody(body, group, mask);
+    }
+
+    //////////////////////////////////////////
+    // closest hit of count rays, from[i] -> to[i], written in hits[i].
+    // Each ray walks the two trees of the broadphase (dynamic and static proxies) with precomputed inverse direction and
+    // signs, and every chunk of rays reuses one traversal stack, so the batch makes no allocation per ray and skips the
+    // filtering and dispatch of btCollisionWorld::rayTest. The chunks run on the job system, if given
+    void rayTestBatch(const btVector3* from, const btVector3* to, int count, RayHit* hits,
+        int group = COL_RAY, int mask = COL_HITSCAN_MASK, JobSystem* jobs = NULL)
+    {
+        if (count <= 0)
+            return;
+
+        // the world is always created with a btDbvtBroadphase (see the constructor)
+        const btDbvtBroadphase* broadphase = (const btDbvtBroadphase*)this->overlappingPairCache;
+
+        ParallelFor(jobs, count, RAY_BATCH_CHUNK, [from, to, hits, group, mask, broadphase](int begin, int end)
+        {
+            btAlignedObjectArray<const btDbvtNode*> stack;
+            btVector3 zero(0.0f, 0.0f, 0.0f);
+
+            for (int i = begin; i < end; i++)
+            {
+                // same ray setup as btCollisionWorld::rayTest
+                btVector3 rayDir = to[i] - from[i];
+                rayDir.safeNormalize();
+                btVector3 rayDirectionInverse;
+                unsigned int signs[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    rayDirectionInverse[k] = rayDir[k] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[k];
+                    signs[k] = rayDirectionInverse[k] < 0.0;
+                }
+                btScalar lambdaMax = rayDir.dot(to[i] - from[i]);
+
+                RayBatchLeafTest test(from[i], to[i], group, mask);
+                for (int set = 0; set < 2; set++)
+                    broadphase->m_sets[set].rayTestInternal(broadphase->m_sets[set].m_root, from[i], to[i], rayDirectionInverse,
+                        signs, lambdaMax, zero, zero, stack, test);
+
+                hits[i].object = test.result.m_collisionObject;
+                hits[i].point = test.result.m_hitPointWorld;
+                hits[i].normal = test.result.m_hitNormalWorld;
+                hits[i].fraction = test.result.m_closestHitFraction;
+            }
+        });
+    }
+
+    //////////////////////////////////////////
+    // we remove a rigid body from the world and delete it, its Collision Shape is deleted if no other body uses it
+    void destroyRigidBody(btRigidBody* body)
+    {
+        this->dynamicsWorld->removeRigidBody(body);
+        delete body->getMotionState();
+        this->collisionShapes->release(body->getCollisionShape());
+        delete body;
+    }
+
     //////////////////////////////////////////
     // We delete the data of the physical simulation when the program ends
     void Clear()
@@ -164,8 +433,9 @@ public:
         //delete dynamics world
         delete this->dynamicsWorld;
 
-        //delete solver
+        //delete solvers
         delete this->solver;
+        delete this->solverMt;
 
         //delete broadphase
         delete this->overlappingPairCache;
@@ -175,6 +445,7 @@ public:
 
         delete this->collisionConfiguration;
 
-        this->collisionShapes.clear();
+        //delete the Collision Shapes, after the bodies using them
+        delete this->collisionShapes;
     }
 };
@@ -0,0 +1,129 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+static float elapsedMs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+Profiler::Profiler()
+    : published(0), frame(0), trace(NULL)
+{
+    for (int i = 0; i < PROFILER_FRAMES; i++)
+        this->ring[i].sequence.store(0, std::memory_order_relaxed);
+    memset(&this->current, 0, sizeof(this->current));
+}
+
+void Profiler::beginFrame()
+{
+    memset(&this->current, 0, sizeof(this->current));
+    this->current.frame = this->frame;
+    this->frameStart = std::chrono::steady_clock::now();
+}
+
+void Profiler::endFrame()
+{
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    this->current.cpu[ZONE_FRAME] = elapsedMs(this->frameStart, end);
+    if (this->trace)
+        this->trace->event(ZONE_NAMES[ZONE_FRAME], this->frameStart, end);
+
+    this->writeSlot(this->ring[this->frame % PROFILER_FRAMES], this->current);
+    this->frame++;
+    this->published.store(this->frame, std::memory_order_release);
+}
+
+void Profiler::beginZone(int zone)
+{
+    this->zoneStart[zone] = std::chrono::steady_clock::now();
+}
+
+void Profiler::endZone(int zone)
+{
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    this->current.cpu[zone] += elapsedMs(this->zoneStart[zone], end);
+    if (this->trace)
+        this->trace->event(ZONE_NAMES[zone], this->zoneStart[zone], end);
+}
+
+void Profiler::setGpuTimes(uint64_t frame, const float* gpu)
+{
+    //only the thread writing the frames changes the slots, a plain read of the own slot is safe
+    Slot& slot = this->ring[frame % PROFILER_FRAMES];
+    if (slot.times.frame != frame || frame >= this->frame)
+        return;
+
+    FrameTimes times = slot.times;
+    memcpy(times.gpu, gpu, sizeof(times.gpu));
+    times.gpuValid = true;
+    this->writeSlot(slot, times);
+}
+
+void Profiler::writeSlot(Slot& slot, const FrameTimes& times)
+{
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.times = times;
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool Profiler::readSlot(Slot& slot, FrameTimes& times)
+{
+    uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before & 1)
+        return false;
+    times = slot.times;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == before;
+}
+
+int Profiler::getFrames(FrameTimes* frames, int count)
+{
+    uint64_t last = this->published.load(std::memory_order_acquire);
+    uint64_t available = std::min<uint64_t>(last, PROFILER_FRAMES);
+    uint64_t first = last - std::min<uint64_t>(available, (uint64_t)count);
+
+    int copied = 0;
+    for (uint64_t f = first; f < last; f++)
+    {
+        //a slot being rewritten, or already holding a newer frame, is skipped
+        if (this->readSlot(this->ring[f % PROFILER_FRAMES], frames[copied]) && frames[copied].frame == f)
+            copied++;
+    }
+    return copied;
+}
+
+ZoneStats Profiler::getStats(int zone, bool gpu)
+{
+    static thread_local std::vector<FrameTimes> frames(PROFILER_FRAMES);
+    static thread_local std::vector<float> values;
+
+    int count = this->getFrames(frames.data(), PROFILER_FRAMES);
+    values.clear();
+    for (int i = 0; i < count; i++)
+    {
+        if (gpu && !frames[i].gpuValid)
+            continue;
+        values.push_back(gpu ? frames[i].gpu[zone] : frames[i].cpu[zone]);
+    }
+
+    ZoneStats stats = {};
+    stats.samples = (int)values.size();
+    if (values.empty())
+        return stats;
+
+    //nearest rank percentiles
+    int p50 = (int)std::ceil(0.50f * values.size()) - 1;
+    int p99 = (int)std::ceil(0.99f * values.size()) - 1;
+    std::nth_element(values.begin(), values.begin() + p50, values.end());
+    stats.p50 = values[p50];
+    std::nth_element(values.begin() + p50, values.begin() + p99, values.end());
+    stats.p99 = values[p99];
+    stats.max = *std::max_element(values.begin() + p99, values.end());
+    return stats;
+}
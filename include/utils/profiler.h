@@ -0,0 +1,130 @@
+/*
+Profiler class
+- CPU timings of the zones of a frame (input, physics, render passes...), measured with scoped ProfileZone objects
+- GPU timings of the same zones, given by a GpuTimer a few frames later when its queries are ready
+- the last PROFILER_FRAMES frames are kept in a lock-free ring, any thread can read them or their percentiles while the
+  main thread keeps writing
+- with a TraceWriter every zone is also streamed to a Chrome trace, for offline analysis of whole sessions
+
+Used to catch the hitches hidden by an averaged FPS counter: p99 and max frame times show single slow frames.
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "traceWriter.h"
+
+//frames kept in the ring, ~4 s at 60 FPS
+#define PROFILER_FRAMES 256
+
+enum profile_zones
+{
+    //the whole frame, from beginFrame to endFrame
+    ZONE_FRAME,
+    ZONE_INPUT,
+    ZONE_PHYSICS,
+    ZONE_SHADOWS,
+    ZONE_MAIN,
+    ZONE_PARTICLES,
+    ZONE_POST,
+    ZONE_TEXT,
+    ZONE_SWAP,
+    ZONE_COUNT
+};
+
+const char* const ZONE_NAMES[ZONE_COUNT] = { "frame", "input", "physics", "shadows", "main", "particles", "post", "text", "swap" };
+
+//timings of a frame in milliseconds, a zone entered more than once in a frame has the sum of its times
+struct FrameTimes
+{
+    uint64_t frame;
+    float cpu[ZONE_COUNT];
+    float gpu[ZONE_COUNT];
+    //the GPU times are given after the frame is published, some frames could have none
+    bool gpuValid;
+};
+
+struct ZoneStats
+{
+    float p50, p99, max;
+    int samples;
+};
+
+class Profiler
+{
+public:
+    Profiler();
+    Profiler(const Profiler& copy) = delete;
+    Profiler& operator=(const Profiler& copy) = delete;
+
+    //the zones must be entered and left between beginFrame and endFrame, on the thread calling them
+    void beginFrame();
+    //publish the CPU times of the frame in the ring
+    void endFrame();
+    void beginZone(int zone);
+    void endZone(int zone);
+
+    //index of the frame being measured
+    uint64_t getFrame() { return this->frame; };
+    //GPU times of an older frame, ignored if it already left the ring
+    void setGpuTimes(uint64_t frame, const float* gpu);
+    //stream the zones to an open trace too, NULL stops it
+    void setTrace(TraceWriter* trace) { this->trace = trace; };
+
+    //copy of the last frames (at most count), oldest first. Safe from any thread, returns the number of frames copied
+    int getFrames(FrameTimes* frames, int count);
+    //percentiles of the CPU or GPU time of a zone over the frames in the ring
+    ZoneStats getStats(int zone, bool gpu);
+
+private:
+    //seqlock slot: the sequence is odd while the writer changes the times
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        FrameTimes times;
+    };
+
+    Slot ring[PROFILER_FRAMES];
+    //frames published so far
+    std::atomic<uint64_t> published;
+
+    uint64_t frame;
+    std::chrono::steady_clock::time_point frameStart;
+    std::chrono::steady_clock::time_point zoneStart[ZONE_COUNT];
+    FrameTimes current;
+    TraceWriter* trace;
+
+    void writeSlot(Slot& slot, const FrameTimes& times);
+    bool readSlot(Slot& slot, FrameTimes& times);
+};
+
+//times a zone from its construction to the end of the scope, does nothing without a profiler
+class ProfileZone
+{
+public:
+    ProfileZone(Profiler* profiler, int zone)
+        : profiler(profiler), zone(zone)
+    {
+        if (this->profiler)
+            this->profiler->beginZone(zone);
+    }
+
+    ~ProfileZone()
+    {
+        if (this->profiler)
+            this->profiler->endZone(this->zone);
+    }
+
+    ProfileZone(const ProfileZone& copy) = delete;
+    ProfileZone& operator=(const ProfileZone& copy) = delete;
+
+private:
+    Profiler* profiler;
+    int zone;
+};
+
+#endif
@@ -0,0 +1,97 @@
+/*
+Random class
+- seeded pseudo random number generator (xoshiro128**) shared by the gameplay and the particle emission
+
+Same seed -> same sequence of targets and particles, so sessions can be reproduced and compared.
+The generator is not thread safe: it must be used from the game thread only.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#define RANDOM_TWO_PI 6.28318530718f
+
+class Random
+{
+public:
+    Random(uint64_t seed = 0x9E3779B97F4A7C15ull)
+    {
+        this->setSeed(seed);
+    }
+
+    // the 128 bit state is expanded from the seed with splitmix64, as suggested by the xoshiro authors
+    void setSeed(uint64_t seed)
+    {
+        this->seed = seed;
+        uint64_t x = seed;
+        for (int i = 0; i < 4; i += 2)
+        {
+            uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            z = z ^ (z >> 31);
+            this->state[i] = (uint32_t)z;
+            this->state[i + 1] = (uint32_t)(z >> 32);
+        }
+    }
+
+    uint64_t getSeed() { return this->seed; }
+
+    uint32_t nextUInt()
+    {
+        uint32_t result = rotl(this->state[1] * 5, 7) * 9;
+        uint32_t t = this->state[1] << 9;
+
+        this->state[2] ^= this->state[0];
+        this->state[3] ^= this->state[1];
+        this->state[1] ^= this->state[2];
+        this->state[0] ^= this->state[3];
+        this->state[2] ^= t;
+        this->state[3] = rotl(this->state[3], 11);
+
+        return result;
+    }
+
+    // uniform in [0, 1), built from the upper 24 bits to fill the float mantissa
+    float nextFloat() { return (this->nextUInt() >> 8) * (1.0f / 16777216.0f); }
+
+    // uniform in [min, max)
+    float range(float min, float max) { return min + (max - min) * this->nextFloat(); }
+
+    // uniform integer in [0, n)
+    int range(int n) { return (int)(((uint64_t)this->nextUInt() * (uint64_t)n) >> 32); }
+
+    // random point in the unit sphere: uniform direction, radius uniform in [0, 1)
+    glm::vec3 inSphere()
+    {
+        float phi = this->nextFloat() * RANDOM_TWO_PI;
+        float cosTheta = this->nextFloat() * 2.0f - 1.0f;
+        float r = this->nextFloat();
+
+        float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+        return glm::vec3(r * sinTheta * std::cos(phi), r * sinTheta * std::sin(phi), r * cosTheta);
+    }
+
+    // fills points with count random points in the unit sphere, used for whole particle bursts
+    void inSphere(glm::vec3* points, int count)
+    {
+        for (int i = 0; i < count; i++)
+            points[i] = this->inSphere();
+    }
+
+private:
+    uint64_t seed;
+    uint32_t state[4];
+
+    static uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+};
+
+// generator shared by the game, seeded at startup
+inline Random& GameRandom()
+{
+    static Random random;
+    return random;
+}
@@ -0,0 +1,296 @@
+#include "scene.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "cookedMap.h"
+#include "hash.h"
+#include "mappedFile.h"
+
+glm::mat4 eulerRotation(glm::vec3 rotation)
+{
+    glm::mat4 matrix = glm::rotate(glm::mat4(1.0f), rotation.x, glm::vec3(0.0f, 1.0f, 0.0f));
+    matrix = glm::rotate(matrix, rotation.y, glm::vec3(1.0f, 0.0f, 0.0f));
+    return glm::rotate(matrix, rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+Scene::Scene()
+    : spawnMin(0.0f), spawnMax(0.0f)
+{
+}
+
+bool Scene::load(const char* path)
+{
+    std::string cookedPath = std::string(path) + COOKED_MAP_EXTENSION;
+
+    //the source is only hashed, it is parsed only if the cooked map is missing or older
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        if (this->loadCooked(cookedPath.c_str(), NULL))
+            return true;
+        std::cout << "Failed to open the map " << path << std::endl;
+        return false;
+    }
+    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    uint64_t sourceHash = fnv1a(source.data(), source.size());
+
+    if (this->loadCooked(cookedPath.c_str(), &sourceHash))
+        return true;
+
+    std::istringstream input(source);
+    if (!this->parse(input, path))
+        return false;
+    this->cook(cookedPath.c_str(), sourceHash);
+    return true;
+}
+
+bool Scene::loadCooked(const char* path, const uint64_t* sourceHash)
+{
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+
+    const CookedMapHeader* header = (const CookedMapHeader*)file.data();
+    if (file.size() < sizeof(CookedMapHeader) || header->magic != COOKED_MAP_MAGIC || header->version != COOKED_MAP_VERSION)
+    {
+        std::cout << "Cooked map " << path << " has an old or unknown format" << std::endl;
+        return false;
+    }
+    if (sourceHash && header->sourceHash != *sourceHash)
+        return false;
+
+    //every array must be inside the file, then the payload must match its checksum
+    uint64_t objects = header->objectCount, models = header->modelCount;
+    bool valid = header->fileSize == file.size()
+        && header->shapeOffset % 16 == 0 && header->shapeOffset + objects * sizeof(CookedShape) <= file.size()
+        && header->instanceOffset % 16 == 0 && header->instanceOffset + objects * sizeof(CookedInstance) <= file.size()
+        && header->modelOffset % 16 == 0 && header->modelOffset + models * sizeof(CookedModel) <= file.size()
+        && header->checksum == fnv1a(file.data() + sizeof(CookedMapHeader), file.size() - sizeof(CookedMapHeader));
+    if (!valid)
+    {
+        std::cout << "Cooked map " << path << " is corrupted" << std::endl;
+        return false;
+    }
+
+    const CookedShape* shapes = (const CookedShape*)(file.data() + header->shapeOffset);
+    const CookedInstance* instances = (const CookedInstance*)(file.data() + header->instanceOffset);
+    const CookedModel* cookedModels = (const CookedModel*)(file.data() + header->modelOffset);
+
+    //the model ranges must cover all the objects in order
+    uint64_t next = 0;
+    for (uint64_t m = 0; valid && m < models; m++)
+    {
+        valid = cookedModels[m].first == next;
+        next += cookedModels[m].count;
+    }
+    if (!valid || next != objects)
+    {
+        std::cout << "Cooked map " << path << " has invalid model ranges" << std::endl;
+        return false;
+    }
+
+    this->position.resize(objects);
+    this->size.resize(objects);
+    this->rotation.resize(objects);
+    this->modelMatrix.resize(objects);
+    this->normalMatrix.resize(objects);
+    for (uint64_t i = 0; i < objects; i++)
+    {
+        this->position[i] = glm::vec3(shapes[i].position[0], shapes[i].position[1], shapes[i].position[2]);
+        this->size[i] = glm::vec3(shapes[i].size[0], shapes[i].size[1], shapes[i].size[2]);
+        this->rotation[i] = glm::vec3(shapes[i].rotation[0], shapes[i].rotation[1], shapes[i].rotation[2]);
+        memcpy(&this->modelMatrix[i], instances[i].modelMatrix, sizeof(glm::mat4));
+        for (int column = 0; column < 3; column++)
+            memcpy(&this->normalMatrix[i][column], &instances[i].normalMatrix[column * 4], sizeof(glm::vec3));
+    }
+
+    this->modelNames.clear();
+    this->model.clear();
+    for (uint64_t m = 0; m < models; m++)
+    {
+        this->modelNames.push_back(std::string(cookedModels[m].name, strnlen(cookedModels[m].name, COOKED_MODEL_NAME_SIZE)));
+        this->model.insert(this->model.end(), cookedModels[m].count, (int)m);
+    }
+    this->updateModelRanges();
+
+    this->spawnMin = glm::vec3(header->spawnMin[0], header->spawnMin[1], header->spawnMin[2]);
+    this->spawnMax = glm::vec3(header->spawnMax[0], header->spawnMax[1], header->spawnMax[2]);
+    return true;
+}
+
+bool Scene::cook(const char* path, uint64_t sourceHash)
+{
+    for (const std::string& name : this->modelNames)
+    {
+        if (name.size() >= COOKED_MODEL_NAME_SIZE)
+        {
+            std::cout << "Can't cook the map " << path << ", the model name " << name << " is too long" << std::endl;
+            return false;
+        }
+    }
+
+    uint32_t objects = (uint32_t)this->count();
+    uint32_t models = (uint32_t)this->modelNames.size();
+
+    //the records are multiples of 16 bytes, so the arrays stay aligned one after the other
+    CookedMapHeader header = {};
+    header.magic = COOKED_MAP_MAGIC;
+    header.version = COOKED_MAP_VERSION;
+    header.sourceHash = sourceHash;
+    header.objectCount = objects;
+    header.modelCount = models;
+    memcpy(header.spawnMin, &this->spawnMin, sizeof(glm::vec3));
+    memcpy(header.spawnMax, &this->spawnMax, sizeof(glm::vec3));
+    header.shapeOffset = sizeof(CookedMapHeader);
+    header.instanceOffset = header.shapeOffset + objects * sizeof(CookedShape);
+    header.modelOffset = header.instanceOffset + objects * sizeof(CookedInstance);
+    header.fileSize = header.modelOffset + models * sizeof(CookedModel);
+
+    std::vector<uint8_t> data(header.fileSize, 0);
+    CookedShape* shapes = (CookedShape*)(data.data() + header.shapeOffset);
+    CookedInstance* instances = (CookedInstance*)(data.data() + header.instanceOffset);
+    CookedModel* cookedModels = (CookedModel*)(data.data() + header.modelOffset);
+    for (uint32_t i = 0; i < objects; i++)
+    {
+        memcpy(shapes[i].position, &this->position[i], sizeof(glm::vec3));
+        memcpy(shapes[i].size, &this->size[i], sizeof(glm::vec3));
+        memcpy(shapes[i].rotation, &this->rotation[i], sizeof(glm::vec3));
+        memcpy(instances[i].modelMatrix, &this->modelMatrix[i], sizeof(glm::mat4));
+        for (int column = 0; column < 3; column++)
+            memcpy(&instances[i].normalMatrix[column * 4], &this->normalMatrix[i][column], sizeof(glm::vec3));
+    }
+    for (uint32_t m = 0; m < models; m++)
+    {
+        memcpy(cookedModels[m].name, this->modelNames[m].c_str(), this->modelNames[m].size());
+        cookedModels[m].first = this->modelFirst[m];
+        cookedModels[m].count = this->modelCount[m];
+    }
+
+    header.checksum = fnv1a(data.data() + sizeof(CookedMapHeader), data.size() - sizeof(CookedMapHeader));
+    memcpy(data.data(), &header, sizeof(CookedMapHeader));
+
+    //a map folder could be read only, the text map is still usable without its cooked form
+    if (!writeFileReplace(path, data.data(), data.size()))
+    {
+        std::cout << "Failed to write the cooked map " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Scene::parse(std::istream& input, const char* name)
+{
+    Scene parsed;
+    bool hasSpawn = false;
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(input, line); lineNumber++)
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string kind;
+        if (!(fields >> kind))
+            continue;
+
+        bool valid = false;
+        if (kind == "box")
+        {
+            std::string modelName;
+            glm::vec3 pos, size, rot(0.0f);
+            valid = (bool)(fields >> modelName >> pos.x >> pos.y >> pos.z >> size.x >> size.y >> size.z);
+
+            //optional rotation, all three angles or none
+            std::vector<float> angles;
+            float angle;
+            while (valid && fields >> angle)
+                angles.push_back(angle);
+            valid = valid && fields.eof() && (angles.empty() || angles.size() == 3);
+            if (valid && !angles.empty())
+                rot = glm::vec3(angles[0], angles[1], angles[2]);
+
+            if (valid)
+            {
+                parsed.position.push_back(pos);
+                parsed.size.push_back(size);
+                parsed.rotation.push_back(rot);
+                parsed.model.push_back(parsed.findModel(modelName));
+            }
+        }
+        else if (kind == "spawn")
+        {
+            valid = (bool)(fields >> parsed.spawnMin.x >> parsed.spawnMin.y >> parsed.spawnMin.z
+                >> parsed.spawnMax.x >> parsed.spawnMax.y >> parsed.spawnMax.z) && !(fields >> kind);
+            hasSpawn = valid;
+        }
+
+        if (!valid)
+        {
+            std::cout << "Map " << name << ", line " << lineNumber << ": invalid entry \"" << line << "\"" << std::endl;
+            return false;
+        }
+    }
+    if (!hasSpawn)
+    {
+        std::cout << "Map " << name << " has no spawn region" << std::endl;
+        return false;
+    }
+
+    //group the objects by model, keeping the file order inside a model
+    std::vector<int> order(parsed.position.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return parsed.model[a] < parsed.model[b]; });
+
+    this->position.clear();
+    this->size.clear();
+    this->rotation.clear();
+    this->model.clear();
+    this->modelMatrix.clear();
+    this->normalMatrix.clear();
+    for (int i : order)
+    {
+        this->position.push_back(parsed.position[i]);
+        this->size.push_back(parsed.size[i]);
+        this->rotation.push_back(parsed.rotation[i]);
+        this->model.push_back(parsed.model[i]);
+
+        glm::mat4 matrix = glm::translate(glm::mat4(1.0f), parsed.position[i]) * eulerRotation(parsed.rotation[i]);
+        matrix = glm::scale(matrix, parsed.size[i]);
+        this->modelMatrix.push_back(matrix);
+        this->normalMatrix.push_back(glm::inverseTranspose(glm::mat3(matrix)));
+    }
+
+    this->modelNames = parsed.modelNames;
+    this->updateModelRanges();
+
+    this->spawnMin = glm::min(parsed.spawnMin, parsed.spawnMax);
+    this->spawnMax = glm::max(parsed.spawnMin, parsed.spawnMax);
+    return true;
+}
+
+void Scene::updateModelRanges()
+{
+    this->modelFirst.assign(this->modelNames.size(), 0);
+    this->modelCount.assign(this->modelNames.size(), 0);
+    for (int i = this->count() - 1; i >= 0; i--)
+    {
+        this->modelFirst[this->model[i]] = i;
+        this->modelCount[this->model[i]]++;
+    }
+}
+
+int Scene::findModel(const std::string& name)
+{
+    for (int i = 0; i < (int)this->modelNames.size(); i++)
+        if (this->modelNames[i] == name)
+            return i;
+    this->modelNames.push_back(name);
+    return (int)this->modelNames.size() - 1;
+}
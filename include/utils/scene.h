@@ -0,0 +1,70 @@
+/*
+Scene class
+- static geometry of a map (walls, floor, cover boxes) loaded from a text map file, see maps/default.map
+- the objects are kept sorted by model in parallel arrays, with their model and normal matrices computed once at load:
+  the renderer uploads them to an instance buffer and draws every model with a single instanced draw per pass
+- the same boxes are the static colliders of the physics world, and the map gives the region where targets spawn
+- the text map is cooked to a binary file next to it on the first load (see cookedMap.h), the next loads map the cooked
+  file and copy its arrays without parsing. Only the cooked file is needed if the text source is not shipped
+
+Map file format, one entry per line, # starts a comment:
+    box <model> px py pz sx sy sz [rx ry rz]    box of half extents s drawn with models/<model>.obj, rotation in radians
+    spawn minx miny minz maxx maxy maxz         region sampled by the spawn volume
+*/
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+//the arena of the original game, relative to the repository root the programs run from
+#define DEFAULT_MAP_PATH "maps/default.map"
+
+class Scene
+{
+public:
+    //static objects, the objects of a model are contiguous
+    std::vector<glm::vec3> position;
+    std::vector<glm::vec3> size;
+    std::vector<glm::vec3> rotation;
+    std::vector<int> model;
+    //world transform of each object and the inverse transpose of its upper 3x3, for the normals
+    std::vector<glm::mat4> modelMatrix;
+    std::vector<glm::mat3> normalMatrix;
+
+    //names of the models used by the map, model indexes this array
+    std::vector<std::string> modelNames;
+    //objects of model m are [modelFirst[m], modelFirst[m] + modelCount[m])
+    std::vector<int> modelFirst;
+    std::vector<int> modelCount;
+
+    glm::vec3 spawnMin, spawnMax;
+
+    Scene();
+
+    //read a map file, or its cooked form if it is up to date. The scene is left unchanged if the map is missing or malformed
+    bool load(const char* path);
+
+    int count() { return (int)this->position.size(); };
+
+    //write the scene in the cooked format, sourceHash is the hash of the text it was parsed from
+    bool cook(const char* path, uint64_t sourceHash);
+
+private:
+    bool parse(std::istream& input, const char* name);
+    //false if the file is missing, invalid, or not cooked from the source with hash sourceHash (any source if NULL)
+    bool loadCooked(const char* path, const uint64_t* sourceHash);
+    //rebuild the model ranges from the model of each object
+    void updateModelRanges();
+    int findModel(const std::string& name);
+};
+
+//rotation used by the physics bodies (btQuaternion::setEuler): yaw around y, pitch around x, roll around z
+glm::mat4 eulerRotation(glm::vec3 rotation);
+
+#endif
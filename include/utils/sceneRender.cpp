@@ -0,0 +1,51 @@
+#include "sceneRender.h"
+
+#include <cstddef>
+
+SceneRenderer::SceneRenderer(Scene& scene, Model** models)
+    : instanceVBO(0)
+{
+    std::vector<SceneInstance> instances(scene.count());
+    for (int i = 0; i < scene.count(); i++)
+    {
+        instances[i].modelMatrix = scene.modelMatrix[i];
+        instances[i].normalMatrix = scene.normalMatrix[i];
+    }
+
+    glGenBuffers(1, &this->instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(SceneInstance), instances.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    for (int m = 0; m < (int)scene.modelNames.size(); m++)
+    {
+        if (!models[m] || scene.modelCount[m] == 0)
+            continue;
+
+        //the attributes of the model start at its first object, so every draw begins at instance 0
+        size_t first = scene.modelFirst[m] * sizeof(SceneInstance);
+        for (Mesh& mesh : models[m]->meshes)
+        {
+            for (int column = 0; column < 4; column++)
+                mesh.setInstanceAttribute(SCENE_INSTANCE_LOCATION + column, 4, this->instanceVBO, sizeof(SceneInstance),
+                    first + offsetof(SceneInstance, modelMatrix) + column * sizeof(glm::vec4));
+            for (int column = 0; column < 3; column++)
+                mesh.setInstanceAttribute(SCENE_INSTANCE_LOCATION + 4 + column, 3, this->instanceVBO, sizeof(SceneInstance),
+                    first + offsetof(SceneInstance, normalMatrix) + column * sizeof(glm::vec3));
+        }
+
+        this->models.push_back(models[m]);
+        this->counts.push_back(scene.modelCount[m]);
+    }
+}
+
+SceneRenderer::~SceneRenderer()
+{
+    glDeleteBuffers(1, &this->instanceVBO);
+}
+
+void SceneRenderer::draw()
+{
+    for (size_t i = 0; i < this->models.size(); i++)
+        this->models[i]->DrawInstanced(this->counts[i]);
+}
@@ -0,0 +1,50 @@
+/*
+SceneRenderer class
+- draws the static objects of a Scene with one instanced draw per model and pass, whatever the number of objects
+- the model and normal matrices cached by the Scene are uploaded once to a static instance buffer, the objects of a
+  model are contiguous in it and the instance attributes of the model's meshes point at their range
+
+The programs drawing the scene are compiled with INSTANCED (shadows.vert, shadowMap.vert), they read the matrices from
+the instance attributes instead of the modelMatrix and normalMatrix uniforms.
+*/
+
+#ifndef SCENE_RENDER_H
+#define SCENE_RENDER_H
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "model.h"
+#include "scene.h"
+
+//first attribute location of the instance data: mat4 model matrix in 5-8, mat3 normal matrix in 9-11
+#define SCENE_INSTANCE_LOCATION 5
+
+//per instance data, the normal matrix is in world space: the shader applies the rotation of the view to it
+struct SceneInstance
+{
+    glm::mat4 modelMatrix;
+    glm::mat3 normalMatrix;
+};
+
+class SceneRenderer
+{
+public:
+    //needs a current GL context. models[m] draws the objects of scene model m, the objects of a null model are skipped
+    SceneRenderer(Scene& scene, Model** models);
+    ~SceneRenderer();
+    SceneRenderer(const SceneRenderer& copy) = delete;
+    SceneRenderer& operator=(const SceneRenderer& copy) = delete;
+
+    //one instanced draw per model, with the program in use
+    void draw();
+
+private:
+    GLuint instanceVBO;
+    std::vector<Model*> models;
+    std::vector<int> counts;
+};
+
+#endif
@@ -12,7 +12,7 @@ Universita' degli Studi di Milano
 */
 
 /*
-    extended with update material function
+    extended with update material function, uniform location table and material uniform buffer
 */
 
 #pragma once
@@ -25,6 +25,8 @@ using namespace std;
 #include <sstream>
 #include <iostream>
 #include "material.h"
+#include "materialBuffer.h"
+#include "uniformTable.h"
 #include <glm/gtc/type_ptr.hpp>
 
 /////////////////// SHADER class ///////////////////////
@@ -32,11 +34,15 @@ class Shader
 {
 public:
     GLuint Program;
+    // locations of the uniforms of the program, resolved once after linking
+    UniformTable uniforms;
 
     //////////////////////////////////////////
 
     //constructor
-    Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
+    // defines (e.g. "#define MATERIAL_UBO\n") are added to both shaders, after their #version line
+    Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const GLchar* defines = NULL)
+        : materialBuffer(NULL)
     {
         // Step 1: we retrieve shaders source code from provided filepaths
         string vertexCode;
@@ -68,6 +74,12 @@ public:
             cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << endl;
         }
 
+        if (defines)
+        {
+            vertexCode = addDefines(vertexCode, defines);
+            fragmentCode = addDefines(fragmentCode, defines);
+        }
+
         // Convert strings to char pointers
         const GLchar* vShaderCode = vertexCode.c_str();
         const GLchar * fShaderCode = fragmentCode.c_str();
@@ -100,28 +112,32 @@ public:
         // Step 4: we delete the shaders because they are linked to the Shader Program, and we do not need them anymore
         glDeleteShader(vertex);
         glDeleteShader(fragment);
+
+        // Step 5: we look up the uniforms once, the draws use the cached locations
+        this->uniforms.resolve(this->Program);
     }
 
-    void updateMaterial(Material material)
+    // programs with the material block read the material from this buffer instead of the material uniforms
+    void setMaterialBuffer(MaterialBuffer* buffer) { this->materialBuffer = buffer; }
+
+    void updateMaterial(const Material& material)
     {
-        GLint ambientLocation = glGetUniformLocation(this->Program, "materialColor.ambient");
-        glUniform3fv(ambientLocation, 1, glm::value_ptr(material.Color.ambient));
-        GLint diffuseLocation = glGetUniformLocation(this->Program, "materialColor.diffuse");
-        glUniform3fv(diffuseLocation, 1, glm::value_ptr(material.Color.diffuse));
-        GLint specularLocation = glGetUniformLocation(this->Program, "materialColor.specular");
-        glUniform3fv(specularLocation, 1, glm::value_ptr(material.Color.specular));
-        GLint shineLocation = glGetUniformLocation(this->Program, "materialColor.shine");
-        glUniform1f(shineLocation, material.Color.shininess);
-
-        GLint ambientLightLocation = glGetUniformLocation(this->Program, "materialLight.ambient");
-        glUniform1f(ambientLightLocation, material.Light.ambient);
-        GLint diffuseLightLocation = glGetUniformLocation(this->Program, "materialLight.diffuse");
-        glUniform1f(diffuseLightLocation, material.Light.diffuse);
-        GLint specularLightLocation = glGetUniformLocation(this->Program, "materialLight.specular");
-        glUniform1f(specularLightLocation, material.Light.specular);
-
-        GLint alphaLocation = glGetUniformLocation(this->Program, "modelAlpha");
-        glUniform1f(alphaLocation, material.alpha);
+        if (this->materialBuffer && this->uniforms.hasMaterialBlock())
+        {
+            this->materialBuffer->upload(material);
+            return;
+        }
+
+        glUniform3fv(this->uniforms[UNIFORM_MATERIAL_AMBIENT], 1, glm::value_ptr(material.Color.ambient));
+        glUniform3fv(this->uniforms[UNIFORM_MATERIAL_DIFFUSE], 1, glm::value_ptr(material.Color.diffuse));
+        glUniform3fv(this->uniforms[UNIFORM_MATERIAL_SPECULAR], 1, glm::value_ptr(material.Color.specular));
+        glUniform1f(this->uniforms[UNIFORM_MATERIAL_SHININESS], material.Color.shininess);
+
+        glUniform1f(this->uniforms[UNIFORM_LIGHT_AMBIENT], material.Light.ambient);
+        glUniform1f(this->uniforms[UNIFORM_LIGHT_DIFFUSE], material.Light.diffuse);
+        glUniform1f(this->uniforms[UNIFORM_LIGHT_SPECULAR], material.Light.specular);
+
+        glUniform1f(this->uniforms[UNIFORM_MODEL_ALPHA], material.alpha);
     }
 
     //////////////////////////////////////////
@@ -133,8 +149,19 @@ public:
     void Delete() { glDeleteProgram(this->Program); }
 
 private:
+    MaterialBuffer* materialBuffer;
+
     //////////////////////////////////////////
 
+    // insert the defines after the #version line (the first line) of the source
+    static string addDefines(const string& code, const GLchar* defines)
+    {
+        size_t lineEnd = code.find('\n');
+        if (lineEnd == string::npos)
+            return code + "\n" + defines;
+        return code.substr(0, lineEnd + 1) + defines + code.substr(lineEnd + 1);
+    }
+
     // Check compilation and linking errors
     void checkCompileErrors(GLuint shader, string type)
 	{
@@ -0,0 +1,113 @@
+#include "spawnVolume.h"
+
+#include <iostream>
+#include <utility>
+
+//counts the world and prop bodies overlapping an AABB
+struct SpawnOverlapCallback : public btBroadphaseAabbCallback
+{
+    int overlaps = 0;
+
+    bool process(const btBroadphaseProxy* proxy)
+    {
+        if (proxy->m_collisionFilterGroup & (COL_WORLD | COL_PROP))
+            this->overlaps++;
+        return true;
+    }
+};
+
+SpawnVolume::SpawnVolume()
+    : cellSize(SPAWN_CELL_SIZE), regionMin(0.0f), regionMax(0.0f), regionCenter(0.0f), cellCount(0), next(0)
+{
+}
+
+int SpawnVolume::build(Physics& physics, glm::vec3 regionMin, glm::vec3 regionMax, float cellSize, float clearance)
+{
+    this->cellSize = cellSize;
+    this->regionMin = regionMin;
+    this->regionMax = regionMax;
+    this->regionCenter = (regionMin + regionMax) * 0.5f;
+    this->cells.clear();
+
+    glm::ivec3 cellCount = glm::max(glm::ivec3(glm::ceil((regionMax - regionMin) / cellSize)), glm::ivec3(1));
+    this->cellCount = cellCount;
+    this->validGrid.assign(cellCount.x * cellCount.y * cellCount.z, 0);
+    btBroadphaseInterface* broadphase = physics.dynamicsWorld->getBroadphase();
+
+    for (int z = 0; z < cellCount.z; z++)
+        for (int y = 0; y < cellCount.y; y++)
+            for (int x = 0; x < cellCount.x; x++)
+            {
+                glm::vec3 cellMin = regionMin + glm::vec3(x, y, z) * cellSize;
+                glm::vec3 cellMax = glm::min(cellMin + cellSize, regionMax);
+
+                //the body AABBs are exact for the axis aligned boxes of the map and conservative for the other shapes
+                SpawnOverlapCallback overlap;
+                broadphase->aabbTest(btVector3(cellMin.x - clearance, cellMin.y - clearance, cellMin.z - clearance),
+                    btVector3(cellMax.x + clearance, cellMax.y + clearance, cellMax.z + clearance), overlap);
+                if (overlap.overlaps == 0)
+                {
+                    this->cells.push_back({ cellMin, cellMax });
+                    this->validGrid[(z * cellCount.y + y) * cellCount.x + x] = 1;
+                }
+            }
+
+    this->order.resize(this->cells.size());
+    for (int i = 0; i < (int)this->order.size(); i++)
+        this->order[i] = i;
+    //start with a new shuffle at the first sample
+    this->next = (int)this->order.size();
+
+    if (this->cells.empty())
+        std::cout << "No valid target spawn cell, targets will spawn at the center of the region" << std::endl;
+
+    return (int)this->cells.size();
+}
+
+bool SpawnVolume::contains(glm::vec3 point) const
+{
+    if (glm::any(glm::lessThan(point, this->regionMin)) || glm::any(glm::greaterThan(point, this->regionMax)))
+        return false;
+
+    //points on the far faces of the region belong to the last cell
+    glm::ivec3 cell = glm::min(glm::ivec3((point - this->regionMin) / this->cellSize), this->cellCount - 1);
+    return this->validGrid[(cell.z * this->cellCount.y + cell.y) * this->cellCount.x + cell.x] != 0;
+}
+
+//Fisher-Yates shuffle of the visit order
+void SpawnVolume::shuffle(Random& random)
+{
+    for (int i = (int)this->order.size() - 1; i > 0; i--)
+        std::swap(this->order[i], this->order[random.range(i + 1)]);
+    this->next = 0;
+}
+
+glm::vec3 SpawnVolume::sample(Random& random, const glm::vec3* avoid, int avoidCount, float minDistance)
+{
+    if (this->cells.empty())
+        return this->regionCenter;
+
+    glm::vec3 point;
+    for (int attempt = 0; attempt < SPAWN_MAX_ATTEMPTS; attempt++)
+    {
+        if (this->next >= (int)this->order.size())
+            this->shuffle(random);
+
+        //uniform point inside the next cell of the round
+        const SpawnCell& cell = this->cells[this->order[this->next++]];
+        //one draw per statement, the evaluation order of function arguments is unspecified
+        point.x = random.range(cell.min.x, cell.max.x);
+        point.y = random.range(cell.min.y, cell.max.y);
+        point.z = random.range(cell.min.z, cell.max.z);
+
+        bool farEnough = true;
+        for (int i = 0; i < avoidCount && farEnough; i++)
+        {
+            glm::vec3 offset = point - avoid[i];
+            farEnough = glm::dot(offset, offset) >= minDistance * minDistance;
+        }
+        if (farEnough)
+            break;
+    }
+    return point;
+}
@@ -0,0 +1,65 @@
+#ifndef SPAWN_VOLUME_H
+#define SPAWN_VOLUME_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "physics.h"
+#include "random.h"
+
+//edge of the cells of the spawn grid
+#define SPAWN_CELL_SIZE 1.0f
+//minimum distance of a new target from the previous one
+#define SPAWN_MIN_DISTANCE 6.0f
+//cells tried before giving up on the minimum distance
+#define SPAWN_MAX_ATTEMPTS 8
+
+//valid cell of the spawn grid, the cells on the far faces of the region are clipped to it
+struct SpawnCell
+{
+    glm::vec3 min, max;
+};
+
+// Grid of the cells of a spawn region where a target fits without touching the static geometry.
+// The grid is built once when the map is loaded, then each spawn is drawn in constant time: the valid cells are visited
+// in a shuffled order, one random point per cell, so the spawns are stratified over the whole region
+class SpawnVolume
+{
+public:
+    SpawnVolume();
+
+    //precompute the valid cells of [regionMin, regionMax]: the ones that, grown by clearance on each side,
+    //don't overlap any world or prop body. Returns the number of valid cells
+    int build(Physics& physics, glm::vec3 regionMin, glm::vec3 regionMax, float cellSize = SPAWN_CELL_SIZE, float clearance = 0.5f);
+
+    //random spawn point at least minDistance away from the avoidCount points of avoid (unless no cell allows it)
+    glm::vec3 sample(Random& random, const glm::vec3* avoid, int avoidCount, float minDistance = SPAWN_MIN_DISTANCE);
+    glm::vec3 sample(Random& random, glm::vec3 avoid, float minDistance = SPAWN_MIN_DISTANCE)
+    {
+        return this->sample(random, &avoid, 1, minDistance);
+    };
+
+    //true if point is inside a valid cell, so a target there doesn't touch the static geometry
+    bool contains(glm::vec3 point) const;
+
+    int validCells() { return (int)this->cells.size(); };
+    glm::vec3 getRegionMin() { return this->regionMin; };
+    glm::vec3 getRegionMax() { return this->regionMax; };
+
+private:
+    float cellSize;
+    glm::vec3 regionMin, regionMax;
+    glm::vec3 regionCenter;
+    std::vector<SpawnCell> cells;
+    //cells of the whole grid, x fastest, 1 for the valid ones
+    glm::ivec3 cellCount;
+    std::vector<unsigned char> validGrid;
+    //shuffled visit order of the cells, next is the position in the current round
+    std::vector<int> order;
+    int next;
+
+    void shuffle(Random& random);
+};
+
+#endif
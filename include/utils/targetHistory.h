@@ -0,0 +1,90 @@
+/*
+TargetHistory class
+- fixed ring buffer with the state of every target in the last TARGET_HISTORY_SIZE simulation ticks
+
+Used to rewind hit tests to the state the player was seeing when shooting. No allocation after resize.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include <bullet/btBulletDynamicsCommon.h>
+
+//ticks kept in the history, 32 ticks are ~130 ms at 240 Hz
+#define TARGET_HISTORY_SIZE 32
+
+//state of a target at the end of a tick
+struct TargetState
+{
+    btRigidBody* body;
+    //the targets don't rotate, the origin is their whole transform
+    btVector3 origin;
+    //the target could be hit (spawned and not shot yet)
+    bool enabled;
+    //the target was moved to a new spawn point during the tick, it is not interpolated from the previous tick
+    bool respawned;
+};
+
+class TargetHistory
+{
+public:
+    TargetHistory()
+        : targetCount(0)
+    {
+        this->Clear();
+    }
+
+    //one slot per target in every tick, clears the history
+    void resize(int targetCount)
+    {
+        this->targetCount = targetCount;
+        this->states.resize(TARGET_HISTORY_SIZE * targetCount);
+        this->Clear();
+    }
+
+    void Clear()
+    {
+        for (int i = 0; i < TARGET_HISTORY_SIZE; i++)
+            this->ticks[i] = -1;
+    }
+
+    //slots of the targets at the end of tick, filled by the caller
+    TargetState* record(int tick)
+    {
+        int frame = tick % TARGET_HISTORY_SIZE;
+        this->ticks[frame] = tick;
+        return &this->states[frame * this->targetCount];
+    }
+
+    //state of a target at tick + alpha, interpolated as the renderer does, false if the tick is not in the history anymore
+    bool sample(int tick, float alpha, int target, TargetState& state)
+    {
+        if (tick < 0)
+            return false;
+        int frame = tick % TARGET_HISTORY_SIZE;
+        if (this->ticks[frame] != tick)
+            return false;
+
+        const TargetState& current = this->states[frame * this->targetCount + target];
+        state = current;
+        if (tick == 0 || current.respawned)
+            return true;
+
+        int previousFrame = (tick - 1) % TARGET_HISTORY_SIZE;
+        if (this->ticks[previousFrame] != tick - 1)
+            return true;
+        const TargetState& previous = this->states[previousFrame * this->targetCount + target];
+        if (previous.body != current.body)
+            return true;
+
+        state.origin = previous.origin.lerp(current.origin, alpha);
+        return true;
+    }
+
+private:
+    int ticks[TARGET_HISTORY_SIZE];
+    int targetCount;
+    //TARGET_HISTORY_SIZE frames of targetCount states
+    std::vector<TargetState> states;
+};
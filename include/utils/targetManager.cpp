@@ -0,0 +1,212 @@
+#include "targetManager.h"
+
+TargetManager::TargetManager(Physics& physics, SpawnVolume& spawnVolume, Random& random)
+    : size(0.5f, 0.5f, 0.5f), physics(physics), spawnVolume(spawnVolume), random(random)
+{
+}
+
+void TargetManager::create(int count, glm::vec3 size)
+{
+    this->size = size;
+    this->position.assign(count, DEFAULT_TARGET_LOCATION);
+    this->previousPosition.assign(count, DEFAULT_TARGET_LOCATION);
+    this->renderPosition.assign(count, DEFAULT_TARGET_LOCATION);
+    this->alpha.assign(count, 1.0f);
+    this->modelIndex.assign(count, 0);
+    this->state.assign(count, TARGET_INACTIVE);
+    this->respawned.assign(count, 0);
+    this->body.resize(count);
+    this->boxBody.resize(count);
+    this->sphereBody.resize(count);
+    this->history.resize(count);
+    this->motion.resize(count);
+
+    //all the bodies stay in the world for the whole session so the broadphase size doesn't change
+    for (int i = 0; i < count; i++)
+    {
+        this->boxBody[i] = this->physics.createRigidBody(BOX,DEFAULT_TARGET_LOCATION,size,glm::vec3(0.0f, 0.0f, 0.0f),0.0f,0.3f,0.0f,
+            COL_TARGET,COL_TARGET_MASK);
+        this->sphereBody[i] = this->physics.createRigidBody(SPHERE,DEFAULT_TARGET_LOCATION,size,glm::vec3(0.0f, 0.0f, 0.0f),0.0f,0.3f,0.0f,
+            COL_TARGET,COL_TARGET_MASK);
+        this->physics.setKinematic(this->boxBody[i]);
+        this->physics.setKinematic(this->sphereBody[i]);
+        this->setBodyEnabled(this->boxBody[i], false);
+        this->setBodyEnabled(this->sphereBody[i], false);
+        this->body[i] = this->boxBody[i];
+    }
+}
+
+void TargetManager::spawnAll()
+{
+    for (int i = 0; i < this->count(); i++)
+        this->spawn(i);
+}
+
+void TargetManager::disableAll()
+{
+    for (int i = 0; i < this->count(); i++)
+    {
+        this->setBodyEnabled(this->body[i], false);
+        this->state[i] = TARGET_INACTIVE;
+        this->alpha[i] = 1.0f;
+        this->motion.stop(i);
+    }
+}
+
+void TargetManager::beginTick()
+{
+    this->previousPosition = this->position;
+}
+
+void TargetManager::update(float deltaTime)
+{
+    float fade = ALPHA_PER_SECOND * deltaTime;
+    for (int i = 0; i < this->count(); i++)
+    {
+        if (this->state[i] != TARGET_FADING)
+            continue;
+        if (this->alpha[i] > 0.0f)
+            this->alpha[i] -= fade;
+        else
+            this->spawn(i);
+    }
+
+    if (!this->motion.moving())
+        return;
+    this->motion.evaluate(deltaTime, this->position.data(), this->random, this->spawnVolume);
+    this->syncBodies();
+}
+
+//the kinematic bodies have no motion state, Bullet reads the transforms written here at the next step, computes their
+//velocities and refreshes their bounds with the others
+void TargetManager::syncBodies()
+{
+    for (int i = 0; i < this->count(); i++)
+    {
+        if (this->state[i] != TARGET_ALIVE)
+            continue;
+        this->body[i]->getWorldTransform().setOrigin(btVector3(this->position[i].x, this->position[i].y, this->position[i].z));
+    }
+}
+
+void TargetManager::interpolate(float alpha)
+{
+    for (int i = 0; i < this->count(); i++)
+        this->renderPosition[i] = glm::mix(this->previousPosition[i], this->position[i], alpha);
+}
+
+void TargetManager::record(int tick)
+{
+    TargetState* states = this->history.record(tick);
+    for (int i = 0; i < this->count(); i++)
+    {
+        states[i].body = this->body[i];
+        states[i].origin = btVector3(this->position[i].x, this->position[i].y, this->position[i].z);
+        states[i].enabled = this->state[i] == TARGET_ALIVE;
+        states[i].respawned = this->respawned[i] != 0;
+        this->respawned[i] = 0;
+    }
+}
+
+void TargetManager::hit(int index)
+{
+    this->state[index] = TARGET_FADING;
+    //move the hitbox out of the way until the fade away is done
+    this->setBodyEnabled(this->body[index], false);
+}
+
+int TargetManager::rayTest(const btVector3& from, const btVector3& to, btScalar maxFraction, int tick, float alpha)
+{
+    btTransform rayFrom, rayTo;
+    rayFrom.setIdentity();
+    rayFrom.setOrigin(from);
+    rayTo.setIdentity();
+    rayTo.setOrigin(to);
+
+    int closest = -1;
+    btScalar closestFraction = maxFraction;
+    for (int i = 0; i < this->count(); i++)
+    {
+        //a target hit after the presented frame is already fading
+        if (this->state[i] != TARGET_ALIVE)
+            continue;
+
+        //state of the target in the frame the player saw, the current one if the history doesn't reach that far
+        TargetState shown;
+        if (!this->history.sample(tick, alpha, i, shown))
+        {
+            shown.body = this->body[i];
+            shown.origin = btVector3(this->position[i].x, this->position[i].y, this->position[i].z);
+            shown.enabled = true;
+        }
+        //respawned since that frame, the player was aiming at the old spawn
+        if (!shown.enabled || shown.body != this->body[i])
+            continue;
+
+        btTransform transform;
+        transform.setIdentity();
+        transform.setOrigin(shown.origin);
+
+        //slab test on the bounds first, most of the targets are far from the ray
+        btVector3 aabbMin, aabbMax, normal;
+        btScalar param = closestFraction;
+        this->body[i]->getCollisionShape()->getAabb(transform, aabbMin, aabbMax);
+        if (!btRayAabb(from, to, aabbMin, aabbMax, param, normal))
+            continue;
+
+        btCollisionWorld::ClosestRayResultCallback res(from, to);
+        res.m_closestHitFraction = closestFraction;
+        btCollisionWorld::rayTestSingle(rayFrom, rayTo, this->body[i], this->body[i]->getCollisionShape(), transform, res);
+        if (res.hasHit())
+        {
+            closest = i;
+            closestFraction = res.m_closestHitFraction;
+        }
+    }
+    return closest;
+}
+
+//move the target to a new point, away from the others, with a new random model, no allocation is done
+void TargetManager::spawn(int index)
+{
+    this->setBodyEnabled(this->body[index], false);
+
+    this->position[index] = this->spawnVolume.sample(this->random, this->position.data(), this->count());
+    this->modelIndex[index] = this->random.range(TARGET_MODEL_COUNT);
+    this->body[index] = (this->modelIndex[index] == SPHERE_TARGET_MODEL) ? this->sphereBody[index] : this->boxBody[index];
+    this->motion.start(index, this->position[index], this->random);
+
+    this->setBodyEnabled(this->body[index], true);
+    this->moveBody(this->body[index], this->position[index]);
+    this->alpha[index] = 1.0f;
+    this->state[index] = TARGET_ALIVE;
+    //a respawn is a jump, not a movement to interpolate
+    this->previousPosition[index] = this->position[index];
+    this->respawned[index] = 1;
+}
+
+void TargetManager::moveBody(btRigidBody* body, glm::vec3 position)
+{
+    btTransform newPos;
+    newPos.setIdentity();
+    newPos.setOrigin(btVector3(position.x, position.y, position.z));
+    body->setWorldTransform(newPos);
+    //a jump, not a movement: the kinematic body gets no velocity from it
+    body->setInterpolationWorldTransform(newPos);
+    //the bounds are not refreshed until the next step, the ray tests need the new ones right away
+    this->physics.dynamicsWorld->updateSingleAabb(body);
+}
+
+void TargetManager::setBodyEnabled(btRigidBody* body, bool enabled)
+{
+    btBroadphaseProxy* proxy = body->getBroadphaseHandle();
+    if (enabled)
+    {
+        proxy->m_collisionFilterMask = COL_TARGET_MASK;
+        return;
+    }
+
+    proxy->m_collisionFilterMask = 0;
+    this->physics.dynamicsWorld->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(proxy, this->physics.dispatcher);
+    this->moveBody(body, DEFAULT_TARGET_LOCATION);
+}
@@ -0,0 +1,106 @@
+/*
+TargetManager class
+- targets of a drill stored in parallel arrays, slot i of every array is target i
+- fade away, respawn and interpolation run over all the targets in one pass
+- every slot owns a box and a sphere body created once, a respawn only moves and enables one of them
+- moving targets follow the paths of TargetMotion, their kinematic bodies are synced in bulk once per tick
+
+Used both by the classic drill (one target) and by gridshot-like drills with dozens of targets alive at the same time.
+*/
+
+#ifndef TARGET_MANAGER_H
+#define TARGET_MANAGER_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "physics.h"
+#include "random.h"
+#include "spawnVolume.h"
+#include "targetHistory.h"
+#include "targetMotion.h"
+
+#define ALPHA_DECAY_TIME 0.2f
+//number of target models, picked at random at every spawn
+#define TARGET_MODEL_COUNT 4
+//index of the target model drawn as a sphere, the other models use the box body
+#define SPHERE_TARGET_MODEL 1
+
+const glm::vec3 DEFAULT_TARGET_LOCATION = glm::vec3(0.0f, -100.0f, 0.0f);
+const float ALPHA_PER_SECOND = 1.0f / ALPHA_DECAY_TIME;
+
+enum target_state
+{
+    //out of the map, not drawn
+    TARGET_INACTIVE,
+    //waiting to be hit
+    TARGET_ALIVE,
+    //hit, fading away before the respawn
+    TARGET_FADING
+};
+
+class TargetManager
+{
+public:
+    //position at the end of the last tick and at the end of the previous one
+    std::vector<glm::vec3> position;
+    std::vector<glm::vec3> previousPosition;
+    //position between the last two ticks, the one drawn by the renderer
+    std::vector<glm::vec3> renderPosition;
+    std::vector<float> alpha;
+    std::vector<int> modelIndex;
+    std::vector<unsigned char> state;
+    //the active body of each target, one of its pool
+    std::vector<btRigidBody*> body;
+    //half size, the same for all the targets
+    glm::vec3 size;
+    //paths of the moving targets, the profile is applied at the next spawn
+    TargetMotion motion;
+
+    TargetManager(Physics& physics, SpawnVolume& spawnVolume, Random& random);
+
+    //create the bodies of count targets, all inactive
+    void create(int count, glm::vec3 size);
+    int count() { return (int)this->state.size(); };
+
+    //spawn all the targets at new points
+    void spawnAll();
+    //move all the targets out of the map
+    void disableAll();
+
+    //start of a tick, the current positions become the previous ones
+    void beginTick();
+    //fade away the hit targets, respawn the ones completely faded and move the targets along their paths
+    void update(float deltaTime);
+    //positions to render at alpha between the last two ticks
+    void interpolate(float alpha);
+    //store the state of the targets at the end of tick in the history
+    void record(int tick);
+
+    //the target starts fading and can't be hit anymore
+    void hit(int index);
+    //index of the closest alive target crossed by the ray before maxFraction, or -1. The targets are tested in the state
+    //they had at tick + alpha, if still in the history
+    int rayTest(const btVector3& from, const btVector3& to, btScalar maxFraction, int tick, float alpha);
+
+private:
+    Physics& physics;
+    SpawnVolume& spawnVolume;
+    Random& random;
+
+    std::vector<btRigidBody*> boxBody;
+    std::vector<btRigidBody*> sphereBody;
+    //spawned during the current tick
+    std::vector<unsigned char> respawned;
+    TargetHistory history;
+
+    void spawn(int index);
+    void moveBody(btRigidBody* body, glm::vec3 position);
+    //an enabled body collides with everything, a disabled one is parked out of the map and collides with nothing
+    void setBodyEnabled(btRigidBody* body, bool enabled);
+    //write the positions of the alive targets in their bodies
+    void syncBodies();
+};
+
+#endif
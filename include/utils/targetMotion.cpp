@@ -0,0 +1,155 @@
+#include "targetMotion.h"
+#include "spawnVolume.h"
+
+#include <cmath>
+#include <cstring>
+
+const MotionProfile* findMotionProfile(const char* name)
+{
+    for (int i = 0; i < MOTION_PROFILE_COUNT; i++)
+        if (strcmp(MOTION_PROFILES[i].name, name) == 0)
+            return &MOTION_PROFILES[i];
+    return NULL;
+}
+
+TargetMotion::TargetMotion()
+    : profile(MOTION_PROFILES[0]), dirty(false)
+{
+}
+
+void TargetMotion::resize(int count)
+{
+    this->path.assign(count, PATH_STATIC);
+    this->anchor.assign(count, glm::vec3(0.0f));
+    this->axis.assign(count, glm::vec3(1.0f, 0.0f, 0.0f));
+    this->time.assign(count, 0.0f);
+    this->velocity.assign(count, glm::vec3(0.0f));
+    this->controls.assign(count * SPLINE_POINTS, glm::vec3(0.0f));
+    for (int i = 0; i < PATH_COUNT; i++)
+    {
+        this->members[i].clear();
+        this->members[i].reserve(count);
+    }
+    this->dirty = false;
+}
+
+void TargetMotion::start(int index, glm::vec3 anchor, Random& random)
+{
+    int path = this->profile.path;
+    if (path == PATH_MIXED)
+        path = PATH_LINEAR + random.range(PATH_COUNT - PATH_LINEAR);
+
+    if (path != this->path[index])
+        this->dirty = true;
+    this->path[index] = (unsigned char)path;
+    this->anchor[index] = anchor;
+    this->time[index] = 0.0f;
+    if (path == PATH_STATIC)
+        return;
+
+    //the strafes and walks are horizontal, the spawn region is thin on the y axis
+    float angle = random.range(0.0f, RANDOM_TWO_PI);
+    this->axis[index] = glm::vec3(std::cos(angle), 0.0f, std::sin(angle));
+    this->velocity[index] = this->axis[index] * (this->profile.speed * 0.5f);
+
+    float range = this->profile.range;
+    glm::vec3* points = &this->controls[index * SPLINE_POINTS];
+    points[0] = anchor;
+    for (int i = 1; i < SPLINE_POINTS; i++)
+        points[i] = anchor + glm::vec3(random.range(-range, range), random.range(-range, range) * 0.25f, random.range(-range, range));
+}
+
+void TargetMotion::stop(int index)
+{
+    if (this->path[index] != PATH_STATIC)
+        this->dirty = true;
+    this->path[index] = PATH_STATIC;
+}
+
+void TargetMotion::groupMembers()
+{
+    for (int i = 0; i < PATH_COUNT; i++)
+        this->members[i].clear();
+    for (int i = 0; i < (int)this->path.size(); i++)
+        this->members[this->path[i]].push_back(i);
+    this->dirty = false;
+}
+
+void TargetMotion::evaluate(float deltaTime, glm::vec3* positions, Random& random, const SpawnVolume& volume)
+{
+    if (this->dirty)
+        this->groupMembers();
+
+    //the target moves to point only if it is clear of the map geometry
+    auto place = [positions, &volume](int i, glm::vec3 point)
+    {
+        if (!volume.contains(point))
+            return false;
+        positions[i] = point;
+        return true;
+    };
+
+    float speed = this->profile.speed;
+    float range = glm::max(this->profile.range, 0.001f);
+    //path length covered in one second, in units of range
+    float rate = speed / range;
+
+    for (int i = 0; i < (int)this->time.size(); i++)
+        this->time[i] += deltaTime;
+
+    //triangle wave in [-1, 1] with period 4, constant speed between the ends
+    for (int i : this->members[PATH_LINEAR])
+    {
+        float u = this->time[i] * rate;
+        float wave = std::fabs(u - 1.0f - 4.0f * std::floor((u - 1.0f) * 0.25f) - 2.0f) - 1.0f;
+        place(i, this->anchor[i] + this->axis[i] * (range * wave));
+    }
+
+    for (int i : this->members[PATH_SINE])
+        place(i, this->anchor[i] + this->axis[i] * (range * std::sin(this->time[i] * rate)));
+
+    //each segment between two control points takes about range / speed seconds
+    for (int i : this->members[PATH_SPLINE])
+    {
+        float s = this->time[i] * rate;
+        float segment = std::floor(s);
+        float t = s - segment;
+        int k = (int)segment;
+        const glm::vec3* points = &this->controls[i * SPLINE_POINTS];
+        glm::vec3 p0 = points[(k + SPLINE_POINTS - 1) % SPLINE_POINTS];
+        glm::vec3 p1 = points[k % SPLINE_POINTS];
+        glm::vec3 p2 = points[(k + 1) % SPLINE_POINTS];
+        glm::vec3 p3 = points[(k + 2) % SPLINE_POINTS];
+
+        float t2 = t * t;
+        float t3 = t2 * t;
+        place(i, 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+            (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3));
+    }
+
+    float maxSpeed2 = speed * speed;
+    float acceleration = RANDOM_WALK_ACCELERATION * deltaTime;
+    for (int i : this->members[PATH_RANDOM_WALK])
+    {
+        glm::vec3 push = random.inSphere() * acceleration;
+        push.y *= 0.25f;
+        glm::vec3 v = this->velocity[i] + push;
+        float v2 = glm::dot(v, v);
+        if (v2 > maxSpeed2)
+            v *= speed / std::sqrt(v2);
+
+        glm::vec3 offset = positions[i] + v * deltaTime - this->anchor[i];
+        float distance2 = glm::dot(offset, offset);
+        //bounce back towards the spawn point at the edge of the range
+        if (distance2 > range * range)
+        {
+            glm::vec3 normal = offset / std::sqrt(distance2);
+            offset = normal * range;
+            v = glm::reflect(v, normal);
+        }
+        //walk away from the geometry it ran into
+        if (!place(i, this->anchor[i] + offset))
+            v = -v;
+        this->velocity[i] = v;
+    }
+}
@@ -0,0 +1,106 @@
+/*
+TargetMotion class
+- kinematic paths of the targets: linear strafes, sine strafes, closed splines and random walks
+- the path parameters are stored in parallel arrays indexed by target. The targets following the same kind of path are
+  listed together and evaluated by one loop per kind, without virtual calls or branches on the path kind
+- a moving target only goes where the spawn volume has a valid cell, so it never enters the map geometry
+
+The motion of a drill is data: a MotionProfile picked by name from MOTION_PROFILES.
+*/
+
+#ifndef TARGET_MOTION_H
+#define TARGET_MOTION_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "random.h"
+
+class SpawnVolume;
+
+//points of the closed spline of each target, the first one is the spawn point
+#define SPLINE_POINTS 4
+//acceleration of the random walks, in m/s^2
+#define RANDOM_WALK_ACCELERATION 20.0f
+
+enum motion_path
+{
+    PATH_STATIC,
+    //back and forth along a line at constant speed
+    PATH_LINEAR,
+    //back and forth along a line, slowing down at the ends
+    PATH_SINE,
+    //closed Catmull-Rom spline around the spawn point
+    PATH_SPLINE,
+    //random changes of velocity, always within the range of the spawn point
+    PATH_RANDOM_WALK,
+    PATH_COUNT
+};
+//profile path picking a random moving path at every spawn
+#define PATH_MIXED PATH_COUNT
+
+struct MotionProfile
+{
+    const char* name;
+    int path;
+    //speed along the path, in m/s
+    float speed;
+    //maximum distance from the spawn point
+    float range;
+};
+
+const MotionProfile MOTION_PROFILES[] = {
+    { "static", PATH_STATIC, 0.0f, 0.0f },
+    { "linear", PATH_LINEAR, 4.0f, 4.0f },
+    { "sine", PATH_SINE, 4.0f, 4.0f },
+    { "spline", PATH_SPLINE, 3.0f, 4.0f },
+    { "walk", PATH_RANDOM_WALK, 3.0f, 5.0f },
+    { "mixed", PATH_MIXED, 3.5f, 4.0f }
+};
+const int MOTION_PROFILE_COUNT = sizeof(MOTION_PROFILES) / sizeof(MOTION_PROFILES[0]);
+
+//profile with the given name, NULL if there is none
+const MotionProfile* findMotionProfile(const char* name);
+
+class TargetMotion
+{
+public:
+    MotionProfile profile;
+
+    //per target path state
+    std::vector<unsigned char> path;
+    //spawn point, the center of the path
+    std::vector<glm::vec3> anchor;
+    //direction of the linear and sine strafes
+    std::vector<glm::vec3> axis;
+    //time since the spawn
+    std::vector<float> time;
+    //velocity of the random walks
+    std::vector<glm::vec3> velocity;
+    //SPLINE_POINTS control points per target
+    std::vector<glm::vec3> controls;
+
+    TargetMotion();
+
+    void resize(int count);
+    bool moving() { return this->profile.path != PATH_STATIC; };
+
+    //new path of the profile for a target spawned at anchor
+    void start(int index, glm::vec3 anchor, Random& random);
+    //the target stops moving, its position is not written anymore
+    void stop(int index);
+
+    //advance all the paths by deltaTime and write the position of each moving target. A target whose new position is
+    //outside the valid cells of volume keeps its position, the random walks also turn back
+    void evaluate(float deltaTime, glm::vec3* positions, Random& random, const SpawnVolume& volume);
+
+private:
+    //targets of each path kind, rebuilt when a path changes
+    std::vector<int> members[PATH_COUNT];
+    bool dirty;
+
+    void groupMembers();
+};
+
+#endif
@@ -1,5 +1,6 @@
 //adapted from https://learnopengl.com/In-Practice/2D-Game/Render-text
 
+#include <algorithm>
 #include <iostream>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -30,31 +31,71 @@ TextRenderer::TextRenderer(unsigned int width, unsigned int height)
 
 void TextRenderer::Load(std::string font, unsigned int fontSize)
 {
-    //clear the previously loaded Characters
-    this->Characters.clear();
-    
-    //initialize and load the FreeType library
+    FontBitmaps bitmaps;
+    TextRenderer::Rasterize(font, fontSize, bitmaps);
+    this->Upload(bitmaps);
+}
+
+bool TextRenderer::Rasterize(std::string font, unsigned int fontSize, FontBitmaps& bitmaps)
+{
+    //initialize and load the FreeType library, one library per call so fonts can be rasterized in parallel
     FT_Library ft;    
     if (FT_Init_FreeType(&ft))
+    {
         std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+        return false;
+    }
     
     // load font as face
     FT_Face face;
     if (FT_New_Face(ft, font.c_str(), 0, &face))
+    {
         std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+        FT_Done_FreeType(ft);
+        return false;
+    }
     // set size to load glyphs as
     FT_Set_Pixel_Sizes(face, 0, fontSize);
-    // disable byte-alignment restriction
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); 
-    // pre-load/compile the first 128 ASCII characters and store them
+    // pre-load the first 128 ASCII characters and store their bitmaps
     for (GLubyte c = 0; c < 128; c++)
     {
+        GlyphBitmap& glyph = bitmaps.Glyphs[c];
+        glyph.Loaded = false;
         // load character glyph 
         if (FT_Load_Char(face, c, FT_LOAD_RENDER))
         {
             std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
             continue;
         }
+        const FT_Bitmap& bitmap = face->glyph->bitmap;
+        glyph.Loaded = true;
+        glyph.Size = glm::ivec2(bitmap.width, bitmap.rows);
+        glyph.Bearing = glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top);
+        glyph.Advance = face->glyph->advance.x;
+        // copy the rows without the padding of the FreeType buffer
+        glyph.Pixels.resize(bitmap.width * bitmap.rows);
+        for (unsigned int row = 0; row < bitmap.rows; row++)
+            std::copy(bitmap.buffer + row * bitmap.pitch, bitmap.buffer + row * bitmap.pitch + bitmap.width,
+                glyph.Pixels.begin() + row * bitmap.width);
+    }
+    // destroy FreeType once we're finished
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+    return true;
+}
+
+void TextRenderer::Upload(const FontBitmaps& bitmaps)
+{
+    //clear the previously loaded Characters
+    this->Characters.clear();
+
+    // disable byte-alignment restriction
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); 
+    for (GLubyte c = 0; c < 128; c++)
+    {
+        const GlyphBitmap& glyph = bitmaps.Glyphs[c];
+        if (!glyph.Loaded)
+            continue;
         // generate texture
         unsigned int texture;
         glGenTextures(1, &texture);
@@ -63,12 +104,12 @@ void TextRenderer::Load(std::string font, unsigned int fontSize)
             GL_TEXTURE_2D,
             0,
             GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
+            glyph.Size.x,
+            glyph.Size.y,
             0,
             GL_RED,
             GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
+            glyph.Pixels.empty() ? NULL : glyph.Pixels.data()
             );
         // set texture options
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -79,16 +120,13 @@ void TextRenderer::Load(std::string font, unsigned int fontSize)
         // now store character for later use
         Character character = {
             texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            face->glyph->advance.x
+            glyph.Size,
+            glyph.Bearing,
+            glyph.Advance
         };
         Characters.insert(std::pair<char, Character>(c, character));
     }
     glBindTexture(GL_TEXTURE_2D, 0);
-    // destroy FreeType once we're finished
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
 }
 
 void TextRenderer::RenderText(std::string text, float x, float y, float scale, glm::vec3 color)
@@ -4,6 +4,8 @@
 #define TEXT_RENDERER_H
 
 #include <map>
+#include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -18,6 +20,20 @@ struct Character {
     unsigned int Advance;   // horizontal offset to advance to next glyph
 };
 
+// glyph rasterized by FreeType and not yet uploaded to a texture
+struct GlyphBitmap {
+    bool         Loaded;
+    std::vector<unsigned char> Pixels; // Size.x * Size.y bytes, one row after the other
+    glm::ivec2   Size;
+    glm::ivec2   Bearing;
+    unsigned int Advance;
+};
+
+// the first 128 ASCII characters of a font, built by TextRenderer::Rasterize on any thread
+struct FontBitmaps {
+    GlyphBitmap Glyphs[128];
+};
+
 
 // A renderer class for rendering text displayed by a font loaded using the 
 // FreeType library. A single font is loaded, processed into a list of Character
@@ -33,6 +49,9 @@ public:
     TextRenderer(unsigned int width, unsigned int height);
     // pre-compiles a list of characters from the given font
     void Load(std::string font, unsigned int fontSize);
+    // the two stages of Load: the glyphs are rasterized without GL calls (so on any thread), then uploaded on the GL thread
+    static bool Rasterize(std::string font, unsigned int fontSize, FontBitmaps& bitmaps);
+    void Upload(const FontBitmaps& bitmaps);
     // renders a string of text using the precompiled list of characters
     void RenderText(std::string text, float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f));
 private:
@@ -0,0 +1,116 @@
+#include "traceWriter.h"
+
+#include <iostream>
+
+TraceWriter::TraceWriter()
+    : file(NULL), head(0), tail(0), dropped(0), stopping(false)
+{
+}
+
+TraceWriter::~TraceWriter()
+{
+    this->close();
+}
+
+bool TraceWriter::open(const char* path)
+{
+    this->close();
+
+    this->file = fopen(path, "wb");
+    if (!this->file)
+    {
+        std::cout << "Failed to create the trace file " << path << std::endl;
+        return false;
+    }
+
+    this->origin = std::chrono::steady_clock::now();
+    this->head.store(0, std::memory_order_relaxed);
+    this->tail.store(0, std::memory_order_relaxed);
+    this->dropped = 0;
+    this->stopping = false;
+
+    //the events are appended after the name of the thread, each one starts with its separator
+    fputs("{\"traceEvents\":[\n", this->file);
+    fputs("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}}", this->file);
+
+    this->writer = std::thread(&TraceWriter::writerLoop, this);
+    return true;
+}
+
+void TraceWriter::close()
+{
+    if (!this->file)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(this->stopMutex);
+        this->stopping = true;
+    }
+    this->stopCondition.notify_one();
+    this->writer.join();
+
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", this->file);
+    fclose(this->file);
+    this->file = NULL;
+
+    if (this->dropped > 0)
+        std::cout << "Trace: " << this->dropped << " events dropped, the writer could not keep up" << std::endl;
+}
+
+void TraceWriter::event(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    uint64_t head = this->head.load(std::memory_order_relaxed);
+    if (head - this->tail.load(std::memory_order_acquire) >= TRACE_RING_SIZE)
+    {
+        this->dropped++;
+        return;
+    }
+
+    TraceEvent& event = this->ring[head % TRACE_RING_SIZE];
+    event.name = name;
+    event.start = std::chrono::duration<double, std::micro>(start - this->origin).count();
+    event.duration = std::chrono::duration<double, std::micro>(end - start).count();
+    this->head.store(head + 1, std::memory_order_release);
+}
+
+void TraceWriter::writerLoop()
+{
+    std::string buffer;
+    buffer.reserve(1 << 20);
+
+    std::unique_lock<std::mutex> lock(this->stopMutex);
+    while (!this->stopping)
+    {
+        this->stopCondition.wait_for(lock, std::chrono::milliseconds(TRACE_FLUSH_INTERVAL));
+        lock.unlock();
+        this->drain(buffer);
+        lock.lock();
+    }
+    lock.unlock();
+
+    //events recorded before close
+    this->drain(buffer);
+}
+
+void TraceWriter::drain(std::string& buffer)
+{
+    uint64_t tail = this->tail.load(std::memory_order_relaxed);
+    uint64_t head = this->head.load(std::memory_order_acquire);
+    if (tail == head)
+        return;
+
+    buffer.clear();
+    char line[160];
+    for (; tail < head; tail++)
+    {
+        const TraceEvent& event = this->ring[tail % TRACE_RING_SIZE];
+        int length = snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+            event.name, event.start, event.duration);
+        if (length > 0 && length < (int)sizeof(line))
+            buffer.append(line, length);
+    }
+    //the slots can be reused once the events are formatted
+    this->tail.store(tail, std::memory_order_release);
+
+    fwrite(buffer.data(), 1, buffer.size(), this->file);
+}
@@ -0,0 +1,75 @@
+/*
+TraceWriter class
+- records timed events (the zones of the profiler) to a Chrome trace JSON file, to be opened in chrome://tracing or Perfetto
+- the recording thread only copies the event into a lock-free single producer ring, a background thread formats the
+  events and writes them to the file in large buffered chunks
+
+If the writer falls behind and the ring fills up the new events are dropped, the number of dropped events is printed
+when the file is closed.
+*/
+
+#ifndef TRACE_WRITER_H
+#define TRACE_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//events in the ring, ~60 frames of zones at 1000 FPS
+#define TRACE_RING_SIZE 16384
+//time between two writes of the background thread, in ms
+#define TRACE_FLUSH_INTERVAL 50
+
+struct TraceEvent
+{
+    //static string, only the pointer is stored
+    const char* name;
+    //microseconds from the opening of the file
+    double start;
+    double duration;
+};
+
+class TraceWriter
+{
+public:
+    TraceWriter();
+    ~TraceWriter();
+    TraceWriter(const TraceWriter& copy) = delete;
+    TraceWriter& operator=(const TraceWriter& copy) = delete;
+
+    //start a new trace, false if the file can't be created
+    bool open(const char* path);
+    //write the remaining events, close the file and stop the background thread
+    void close();
+    bool isOpen() { return this->file != NULL; };
+
+    //a complete event, name must outlive the writer. Only one thread can record events
+    void event(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+private:
+    FILE* file;
+    std::chrono::steady_clock::time_point origin;
+
+    TraceEvent ring[TRACE_RING_SIZE];
+    //events written by the recording thread and read by the background thread
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    uint64_t dropped;
+
+    std::thread writer;
+    std::mutex stopMutex;
+    std::condition_variable stopCondition;
+    bool stopping;
+
+    void writerLoop();
+    //format the events in the ring and write them to the file, on the background thread
+    void drain(std::string& buffer);
+};
+
+#endif
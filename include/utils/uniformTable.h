@@ -0,0 +1,105 @@
+/*
+UniformTable class
+- locations of the uniforms used by the renderer, resolved once after a Shader Program is linked
+- the GL calls go through a small function table, so the lookup can run against stub functions without a GL context
+
+The uniforms a program doesn't use get location -1, the glUniform calls ignore them as they did with a lookup per call.
+*/
+
+#pragma once
+
+#include <glad/glad.h>
+
+enum shader_uniforms
+{
+    UNIFORM_MODEL_MATRIX,
+    UNIFORM_NORMAL_MATRIX,
+    UNIFORM_VIEW,
+    UNIFORM_PROJECTION,
+    UNIFORM_LIGHT_POV,
+    UNIFORM_LIGHT_VECTOR,
+    UNIFORM_SHADOW_MAP,
+    UNIFORM_SKYBOX,
+    UNIFORM_CAMERA_RIGHT,
+    UNIFORM_CAMERA_UP,
+    UNIFORM_VIEW_PROJECTION,
+    UNIFORM_MATERIAL_AMBIENT,
+    UNIFORM_MATERIAL_DIFFUSE,
+    UNIFORM_MATERIAL_SPECULAR,
+    UNIFORM_MATERIAL_SHININESS,
+    UNIFORM_LIGHT_AMBIENT,
+    UNIFORM_LIGHT_DIFFUSE,
+    UNIFORM_LIGHT_SPECULAR,
+    UNIFORM_MODEL_ALPHA,
+    UNIFORM_COUNT
+};
+
+const char* const UNIFORM_NAMES[UNIFORM_COUNT] = {
+    "modelMatrix",
+    "normalMatrix",
+    "view",
+    "projection",
+    "lightPOV",
+    "lightVector",
+    "shadowMap",
+    "skybox",
+    "cameraRightVector",
+    "cameraUpVector",
+    "ViewProjection",
+    "materialColor.ambient",
+    "materialColor.diffuse",
+    "materialColor.specular",
+    "materialColor.shininess",
+    "materialLight.ambient",
+    "materialLight.diffuse",
+    "materialLight.specular",
+    "modelAlpha"
+};
+
+//uniform block replacing the material uniforms, see MaterialBuffer
+#define MATERIAL_BLOCK_NAME "MaterialBlock"
+#define MATERIAL_BLOCK_BINDING 0
+
+//GL functions used to resolve the table
+struct UniformFunctions
+{
+    PFNGLGETUNIFORMLOCATIONPROC getUniformLocation;
+    PFNGLGETUNIFORMBLOCKINDEXPROC getUniformBlockIndex;
+    PFNGLUNIFORMBLOCKBINDINGPROC uniformBlockBinding;
+};
+
+//the functions loaded by glad, valid once the GL context is created
+inline UniformFunctions gladUniformFunctions()
+{
+    return { glad_glGetUniformLocation, glad_glGetUniformBlockIndex, glad_glUniformBlockBinding };
+}
+
+class UniformTable
+{
+public:
+    GLint locations[UNIFORM_COUNT];
+    //index of the material block in the program, GL_INVALID_INDEX if the program uses the material uniforms
+    GLuint materialBlock;
+
+    UniformTable()
+    {
+        for (int i = 0; i < UNIFORM_COUNT; i++)
+            this->locations[i] = -1;
+        this->materialBlock = GL_INVALID_INDEX;
+    }
+
+    //look up all the uniforms of a linked program, the material block is bound to MATERIAL_BLOCK_BINDING
+    void resolve(GLuint program, const UniformFunctions& gl = gladUniformFunctions())
+    {
+        for (int i = 0; i < UNIFORM_COUNT; i++)
+            this->locations[i] = gl.getUniformLocation(program, UNIFORM_NAMES[i]);
+
+        this->materialBlock = gl.getUniformBlockIndex(program, MATERIAL_BLOCK_NAME);
+        if (this->materialBlock != GL_INVALID_INDEX)
+            gl.uniformBlockBinding(program, this->materialBlock, MATERIAL_BLOCK_BINDING);
+    }
+
+    GLint operator[](int uniform) const { return this->locations[uniform]; }
+
+    bool hasMaterialBlock() const { return this->materialBlock != GL_INVALID_INDEX; }
+};
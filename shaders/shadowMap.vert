@@ -4,10 +4,18 @@ layout (location = 0) in vec3 position;
 
 uniform mat4 lightPOV;
 
+#ifdef INSTANCED
+//static scene objects, one model matrix per instance
+layout (location = 5) in mat4 instanceModelMatrix;
+#else
 uniform mat4 modelMatrix;
+#endif
 
 void main()
 {
+#ifdef INSTANCED
+    mat4 modelMatrix = instanceModelMatrix;
+#endif
 	//vertex pos from light POV
     gl_Position = lightPOV * modelMatrix * vec4(position, 1.0f);
 }
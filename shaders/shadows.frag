@@ -66,8 +66,6 @@ struct MaterialColor {
     vec3 specular;
     float shininess;
 }; 
-  
-uniform MaterialColor materialColor;
 
 struct MaterialLight {  
     float ambient;
@@ -75,9 +73,20 @@ struct MaterialLight {
     float specular;
 };
 
+#ifdef MATERIAL_UBO
+//the whole material in one uniform buffer, the layout is mirrored by MaterialBlock in materialBuffer.h
+layout (std140) uniform MaterialBlock {
+    MaterialColor materialColor;
+    MaterialLight materialLight;
+    float modelAlpha;
+};
+#else
+uniform MaterialColor materialColor;
+
 uniform float modelAlpha;
 
 uniform MaterialLight materialLight;
+#endif
 
 float F0 = 0.9f;
 float alpha = materialColor.shininess;
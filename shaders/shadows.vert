@@ -4,12 +4,19 @@ layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 normal;
 
 
+#ifdef INSTANCED
+//static scene objects, one model matrix and world space normal matrix per instance
+layout (location = 5) in mat4 instanceModelMatrix;
+layout (location = 9) in mat3 instanceNormalMatrix;
+#else
 uniform mat4 modelMatrix;
-uniform mat4 view;
-uniform mat4 projection;
 
 //normals transformation matrix
 uniform mat3 normalMatrix;
+#endif
+
+uniform mat4 view;
+uniform mat4 projection;
 
 //transformation matrix to light POV
 uniform mat4 lightPOV;
@@ -28,6 +35,11 @@ out vec4 posLightPOV;
 
 void main()
 {
+#ifdef INSTANCED
+  mat4 modelMatrix = instanceModelMatrix;
+  //the view only rotates and translates, so its rotation can be applied after the world space normal matrix
+  mat3 normalMatrix = mat3(view) * instanceNormalMatrix;
+#endif
 
   vec4 mPosition = modelMatrix * vec4( position, 1.0 );
   // vertex position in camera coordinates
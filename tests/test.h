@@ -0,0 +1,24 @@
+//minimal check helper shared by the tests, run by ctest
+
+#pragma once
+
+#include <iostream>
+
+//number of failed checks, main returns non zero if any check failed
+inline int testFailures = 0;
+
+//prints the failed condition with its location and keeps going, so one run reports all the failures
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) \
+        { \
+            std::cout << __FILE__ << ":" << __LINE__ << ": check failed: " << #condition << std::endl; \
+            testFailures++; \
+        } \
+    } while (0)
+
+inline int testResult(const char* name)
+{
+    std::cout << name << ": " << (testFailures == 0 ? "passed" : "FAILED") << std::endl;
+    return testFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+//ring and fence logic of the particle instance buffers, driven through the CPU-only backend
+
+#include "test.h"
+#include "utils/particleBuffer.h"
+
+#define CAPACITY 64
+#define FRAMES 12
+
+//one frame of the renderer: reserve the slot, write count instances, publish them and fence the draw
+static ParticleBufferRegion runFrame(ParticleBufferRing& ring, int count)
+{
+    ParticleBufferRegion region = ring.begin();
+    for (int i = 0; i < count * 4; i++)
+    {
+        region.posSize[i] = 1.0f;
+        region.color[i] = 255;
+    }
+    ring.commit(count);
+    ring.end();
+    return region;
+}
+
+//each frame waits on the fence of its own slot before writing it, the slots are visited in order
+static void testWaitOrder()
+{
+    CpuParticleBuffers buffers;
+    ParticleBufferRing ring(&buffers, CAPACITY);
+
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        int slot = frame % PARTICLE_BUFFER_FRAMES;
+        //the fence of the frame that last used the slot is still there until begin waits on it
+        CHECK(buffers.fenced(slot) == (frame >= PARTICLE_BUFFER_FRAMES));
+        ParticleBufferRegion region = ring.begin();
+        CHECK(!buffers.fenced(slot));
+        CHECK((int)buffers.waits.size() == frame + 1 && buffers.waits.back() == slot);
+        CHECK(region.firstInstance == slot * CAPACITY);
+        ring.commit(1);
+        ring.end();
+        CHECK(buffers.fenced(slot));
+    }
+}
+
+//a slot is written again only PARTICLE_BUFFER_FRAMES frames later: the writes stall only if the GPU lags more than that
+static void testSlotReuse()
+{
+    for (int latency = 1; latency <= PARTICLE_BUFFER_FRAMES + 1; latency++)
+    {
+        CpuParticleBuffers buffers(latency);
+        ParticleBufferRing ring(&buffers, CAPACITY);
+
+        GLfloat* written[FRAMES];
+        for (int frame = 0; frame < FRAMES; frame++)
+            written[frame] = runFrame(ring, CAPACITY).posSize;
+
+        for (int frame = 0; frame < FRAMES; frame++)
+            for (int other = frame + 1; other < FRAMES; other++)
+                CHECK((written[frame] == written[other]) == ((other - frame) % PARTICLE_BUFFER_FRAMES == 0));
+
+        //when frame f waits, the fence of frame f - PARTICLE_BUFFER_FRAMES has PARTICLE_BUFFER_FRAMES - 1 newer fences
+        int expectedStalls = latency >= PARTICLE_BUFFER_FRAMES ? FRAMES - PARTICLE_BUFFER_FRAMES : 0;
+        CHECK(buffers.stalls == expectedStalls);
+    }
+}
+
+//only the used part of the slot is published, at the offset of the slot in both buffers
+static void testCommitRanges()
+{
+    CpuParticleBuffers buffers;
+    ParticleBufferRing ring(&buffers, CAPACITY);
+    CHECK(buffers.posSizeMemory.size() == (size_t)PARTICLE_BUFFER_FRAMES * CAPACITY * 4);
+    CHECK(buffers.colorMemory.size() == (size_t)PARTICLE_BUFFER_FRAMES * CAPACITY * 4);
+
+    size_t total = 0;
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        int count = (frame * 7) % (CAPACITY + 1);
+        int slot = frame % PARTICLE_BUFFER_FRAMES;
+        ParticleBufferRegion region = runFrame(ring, count);
+
+        CHECK(region.posSize == buffers.posSizeMemory.data() + slot * CAPACITY * 4);
+        CHECK(region.color == buffers.colorMemory.data() + slot * CAPACITY * 4);
+        CHECK(buffers.lastPosSizeOffset == (size_t)slot * CAPACITY * 4 * sizeof(GLfloat));
+        CHECK(buffers.lastPosSizeBytes == (size_t)count * 4 * sizeof(GLfloat));
+        CHECK(buffers.lastColorOffset == (size_t)slot * CAPACITY * 4 * sizeof(GLubyte));
+        CHECK(buffers.lastColorBytes == (size_t)count * 4 * sizeof(GLubyte));
+        total += count * 4 * (sizeof(GLfloat) + sizeof(GLubyte));
+    }
+    CHECK(buffers.commits == FRAMES);
+    CHECK(buffers.committedBytes == total);
+}
+
+int main()
+{
+    testWaitOrder();
+    testSlotReuse();
+    testCommitRanges();
+    return testResult("particle buffer ring");
+}
@@ -0,0 +1,101 @@
+//uniform location table, resolved against stub GL functions instead of a GL context
+
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "test.h"
+#include "utils/uniformTable.h"
+
+#define PROGRAM_WITH_BLOCK 7
+#define PROGRAM_WITHOUT_BLOCK 8
+#define STUB_BLOCK_INDEX 3
+
+//uniforms of the stub programs and the calls the table made
+static std::map<std::string, GLint> stubUniforms;
+static int locationCalls = 0;
+static int bindingCalls = 0;
+static GLuint boundProgram = 0, boundIndex = GL_INVALID_INDEX, boundBinding = 0;
+
+static GLint APIENTRY stubGetUniformLocation(GLuint, const GLchar* name)
+{
+    locationCalls++;
+    auto uniform = stubUniforms.find(name);
+    return uniform == stubUniforms.end() ? -1 : uniform->second;
+}
+
+static GLuint APIENTRY stubGetUniformBlockIndex(GLuint program, const GLchar* name)
+{
+    if (program == PROGRAM_WITH_BLOCK && strcmp(name, MATERIAL_BLOCK_NAME) == 0)
+        return STUB_BLOCK_INDEX;
+    return GL_INVALID_INDEX;
+}
+
+static void APIENTRY stubUniformBlockBinding(GLuint program, GLuint index, GLuint binding)
+{
+    bindingCalls++;
+    boundProgram = program;
+    boundIndex = index;
+    boundBinding = binding;
+}
+
+static const UniformFunctions STUB_FUNCTIONS = { stubGetUniformLocation, stubGetUniformBlockIndex, stubUniformBlockBinding };
+
+//every name is looked up once, then the locations are read from the table
+static void testLocations()
+{
+    stubUniforms = { { "modelMatrix", 4 }, { "view", 9 }, { "projection", 2 }, { "modelAlpha", 11 } };
+    locationCalls = 0;
+
+    UniformTable table;
+    CHECK(table[UNIFORM_VIEW] == -1);
+    table.resolve(PROGRAM_WITH_BLOCK, STUB_FUNCTIONS);
+    CHECK(locationCalls == UNIFORM_COUNT);
+
+    CHECK(table[UNIFORM_MODEL_MATRIX] == 4);
+    CHECK(table[UNIFORM_VIEW] == 9);
+    CHECK(table[UNIFORM_PROJECTION] == 2);
+    CHECK(table[UNIFORM_MODEL_ALPHA] == 11);
+    //reading the table doesn't go back to GL
+    CHECK(locationCalls == UNIFORM_COUNT);
+}
+
+//the uniforms the program doesn't use get -1, which the glUniform calls ignore
+static void testMissingUniforms()
+{
+    stubUniforms = { { "view", 0 } };
+
+    UniformTable table;
+    table.resolve(PROGRAM_WITHOUT_BLOCK, STUB_FUNCTIONS);
+    CHECK(table[UNIFORM_VIEW] == 0);
+    for (int i = 0; i < UNIFORM_COUNT; i++)
+        if (i != UNIFORM_VIEW)
+            CHECK(table[i] == -1);
+}
+
+//the material block is bound to MATERIAL_BLOCK_BINDING, the programs without it are left alone
+static void testMaterialBlock()
+{
+    stubUniforms.clear();
+    bindingCalls = 0;
+
+    UniformTable withBlock;
+    withBlock.resolve(PROGRAM_WITH_BLOCK, STUB_FUNCTIONS);
+    CHECK(withBlock.hasMaterialBlock());
+    CHECK(withBlock.materialBlock == STUB_BLOCK_INDEX);
+    CHECK(bindingCalls == 1);
+    CHECK(boundProgram == PROGRAM_WITH_BLOCK && boundIndex == STUB_BLOCK_INDEX && boundBinding == MATERIAL_BLOCK_BINDING);
+
+    UniformTable withoutBlock;
+    withoutBlock.resolve(PROGRAM_WITHOUT_BLOCK, STUB_FUNCTIONS);
+    CHECK(!withoutBlock.hasMaterialBlock());
+    CHECK(bindingCalls == 1);
+}
+
+int main()
+{
+    testLocations();
+    testMissingUniforms();
+    testMaterialBlock();
+    return testResult("uniform table");
+}